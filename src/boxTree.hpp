@@ -0,0 +1,197 @@
+#pragma once
+#include "sweep.hpp"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+// Closed axis aligned box
+template <typename T>
+struct Box {
+  T minX, minY, maxX, maxY;
+
+  static Box of(const BasicSegment<T>& s) {
+    return {std::min(s.a.x, s.b.x), std::min(s.a.y, s.b.y), std::max(s.a.x, s.b.x), std::max(s.a.y, s.b.y)};
+  }
+
+  bool overlaps(const Box& o) const {
+    return minX <= o.maxX && o.minX <= maxX && minY <= o.maxY && o.minY <= maxY;
+  }
+
+  void extend(const Box& o) {
+    minX = std::min(minX, o.minX);
+    minY = std::min(minY, o.minY);
+    maxX = std::max(maxX, o.maxX);
+    maxY = std::max(maxY, o.maxY);
+  }
+
+  // Exact: the closed segment s meets the closed box. Past the box test
+  // the only miss left is all four corners strictly on one side of s
+  bool crossedBy(const BasicSegment<T>& s) const {
+    if (!overlaps(of(s))) return false;
+    int c1 = orientSign(s.a.x, s.a.y, s.b.x, s.b.y, minX, minY);
+    int c2 = orientSign(s.a.x, s.a.y, s.b.x, s.b.y, maxX, minY);
+    int c3 = orientSign(s.a.x, s.a.y, s.b.x, s.b.y, minX, maxY);
+    int c4 = orientSign(s.a.x, s.a.y, s.b.x, s.b.y, maxX, maxY);
+    return !((c1 > 0 && c2 > 0 && c3 > 0 && c4 > 0) || (c1 < 0 && c2 < 0 && c3 < 0 && c4 < 0));
+  }
+
+  // In double, int64 coordinates may overflow a sum
+  double centerX() const { return (double(minX) + double(maxX)) / 2; }
+  double centerY() const { return (double(minY) + double(maxY)) / 2; }
+  double area() const { return (double(maxX) - double(minX)) * (double(maxY) - double(minY)); }
+};
+
+/**
+ * Static R-tree over segment bounding boxes, bulk loaded with
+ * Sort-Tile-Recursive packing.
+ *
+ * Every level is tiled into vertical slices by box center x, each slice
+ * sorted by center y and cut into runs of FANOUT entries, so nodes are full
+ * and spatially tight. All nodes live in one array with the children of a
+ * node contiguous and the root last; a leaf covers a range of order(), the
+ * segment ids in leaf order, whose boxes are kept alongside so queries
+ * never touch segments that miss. Built once in O(n log n).
+ */
+template <typename T>
+class BoxTree {
+  public:
+  // At most KERNEL_BLOCK, a leaf is tested against another in one block
+  static constexpr int FANOUT = 16;
+
+  struct Node {
+    Box<T> box;
+    int    first, count; // order() range for leaves, child nodes otherwise
+    bool   leaf;
+  };
+
+  BoxTree() = default;
+
+  explicit BoxTree(const std::vector<BasicSegment<T>>& segments) :
+    BoxTree(segments, allIds(segments.size())) {}
+
+  // Tree over a subset of the segments, order() and queries report the
+  // given ids
+  BoxTree(const std::vector<BasicSegment<T>>& segments, std::vector<int> subset) :
+    ids(std::move(subset)) {
+    int n = ids.size();
+    if (n == 0) return;
+
+    auto boxOf = [&](int i) { return Box<T>::of(segments[i]); };
+    tile(ids, boxOf);
+
+    boxes.resize(n);
+    for (int k = 0; k < n; ++k) boxes[k] = boxOf(ids[k]);
+
+    std::vector<Node> level;
+    for (int k = 0; k < n; k += FANOUT) {
+      Node leaf = {boxes[k], k, std::min(FANOUT, n - k), true};
+      for (int m = k + 1; m < k + leaf.count; ++m) leaf.box.extend(boxes[m]);
+      level.push_back(leaf);
+    }
+
+    // Each pass tiles the current level, stores it and groups it in parents
+    while (level.size() > 1) {
+      tile(level, [](const Node& node) { return node.box; });
+      int first = nodes.size();
+      nodes.insert(nodes.end(), level.begin(), level.end());
+
+      std::vector<Node> parents;
+      for (int k = 0; k < (int)level.size(); k += FANOUT) {
+        Node parent = {level[k].box, first + k, std::min<int>(FANOUT, level.size() - k), false};
+        for (int m = k + 1; m < k + parent.count; ++m) parent.box.extend(level[m].box);
+        parents.push_back(parent);
+      }
+      level = std::move(parents);
+    }
+    nodes.push_back(level[0]);
+  }
+
+  // Segment ids in leaf order
+  const std::vector<int>& order() const { return ids; }
+  size_t                  size() const { return ids.size(); }
+
+  // Box of the whole tree, only meaningful when size() > 0
+  const Box<T>& bounds() const { return nodes[root()].box; }
+
+  // Calls visit(id) for every segment whose own box overlaps box
+  template <typename Visit>
+  void query(const Box<T>& box, Visit&& visit) const {
+    if (nodes.empty()) return;
+    // At most 8 levels below 2^31 ids, each leaving FANOUT - 1 siblings
+    int stack[8 * FANOUT];
+    int top      = 0;
+    stack[top++] = root();
+
+    while (top > 0) {
+      const Node& node = nodes[stack[--top]];
+      if (!node.box.overlaps(box)) continue;
+      for (int k = node.first; k < node.first + node.count; ++k) {
+        if (!node.leaf) stack[top++] = k;
+        else if (boxes[k].overlaps(box)) visit(ids[k]);
+      }
+    }
+  }
+
+  /**
+   * Dual tree self join: walks pairs of nodes whose boxes overlap, starting
+   * from (root, root), and calls visit(a, na, b, nb) for every pair of
+   * overlapping leaves, ranges of order(), each unordered pair once. a == b
+   * is a leaf joined with itself. visit returns false to stop the walk.
+   */
+  template <typename Visit>
+  void selfJoin(Visit&& visit) const {
+    if (nodes.empty()) return;
+    std::vector<std::pair<int, int>> stack = {{root(), root()}};
+
+    while (!stack.empty()) {
+      auto [a, b] = stack.back();
+      stack.pop_back();
+      const Node& na = nodes[a];
+      const Node& nb = nodes[b];
+
+      if (na.leaf && nb.leaf) {
+        if (!visit(na.first, na.count, nb.first, nb.count)) return;
+      } else if (a == b) {
+        for (int i = na.first; i < na.first + na.count; ++i)
+          for (int j = i; j < na.first + na.count; ++j)
+            if (i == j || nodes[i].box.overlaps(nodes[j].box)) stack.push_back({i, j});
+      } else {
+        // Descend into the larger inner node
+        bool        split = nb.leaf || (!na.leaf && na.box.area() >= nb.box.area());
+        const Node& inner = split ? na : nb;
+        int         other = split ? b : a;
+        for (int i = inner.first; i < inner.first + inner.count; ++i)
+          if (nodes[i].box.overlaps(nodes[other].box)) stack.push_back({i, other});
+      }
+    }
+  }
+
+  private:
+  std::vector<int>    ids;
+  std::vector<Box<T>> boxes; // of ids[k], in leaf order
+  std::vector<Node>   nodes;
+
+  int root() const { return nodes.size() - 1; }
+
+  static std::vector<int> allIds(int n) {
+    std::vector<int> all(n);
+    std::iota(all.begin(), all.end(), 0);
+    return all;
+  }
+
+  // Sort-Tile-Recursive order of items: ceil(sqrt(runs)) slices by center
+  // x, each sorted by center y
+  template <typename Item, typename BoxOf>
+  static void tile(std::vector<Item>& items, BoxOf boxOf) {
+    size_t runs   = (items.size() + FANOUT - 1) / FANOUT;
+    size_t slices = std::ceil(std::sqrt(double(runs)));
+    size_t width  = ((runs + slices - 1) / slices) * FANOUT;
+
+    std::sort(items.begin(), items.end(), [&](const Item& l, const Item& r) { return boxOf(l).centerX() < boxOf(r).centerX(); });
+    for (size_t s = 0; s < items.size(); s += width) {
+      auto end = items.begin() + std::min(items.size(), s + width);
+      std::sort(items.begin() + s, end, [&](const Item& l, const Item& r) { return boxOf(l).centerY() < boxOf(r).centerY(); });
+    }
+  }
+};
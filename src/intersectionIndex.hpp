@@ -0,0 +1,129 @@
+#pragma once
+#include "sweep.hpp"
+#include "boxTree.hpp"
+#include <map>
+#include <set>
+#include <vector>
+
+/**
+ * Intersection map kept up to date under segment insertions and removals.
+ *
+ * Live segments are spread over a short stack of packed BoxTrees with
+ * geometrically decreasing sizes plus a tail of at most TAIL recent
+ * insertions scanned linearly (the logarithmic method). A full tail becomes
+ * a new tree, merged with the trees above it while they are not more than
+ * twice its size, so every segment is rebuilt O(log n) times overall.
+ * insert() tests the new segment against the box query of each tree and
+ * the tail, remove() unlinks the segment from its neighbours in the map;
+ * both cost time proportional to the edit, not to the whole set.
+ *
+ * Ids are the positions in the initial segment list followed by insertion
+ * order and are never reused. Removed segments stay in the trees until the
+ * next merge and are skipped by the queries; once they outnumber the live
+ * ones everything is rebuilt into a single tree.
+ */
+template <typename T>
+class IntersectionIndex {
+  public:
+  static constexpr int TAIL = 64;
+
+  explicit IntersectionIndex(std::vector<BasicSegment<T>> initial = {}) :
+    segments(std::move(initial)), live(segments.size(), true), liveCount(segments.size()) {
+    BasicSweepinfo<T> info;
+    info.segments = segments;
+    info.mode     = ResultMode::PairsOnly;
+    maps          = findIntersectionsLibrary(info).intersectionMaps;
+    for (const auto& [i, hits] : maps) pairs += hits.size();
+    pairs /= 2;
+
+    rebuild();
+  }
+
+  // Adds s and returns its id
+  int insert(const BasicSegment<T>& s) {
+    int id = segments.size();
+    segments.push_back(s);
+    live.push_back(true);
+    liveCount++;
+
+    Box<T> box  = Box<T>::of(s);
+    auto   test = [&](int j) {
+      BasicPoint<T> p;
+      if (!live[j] || !segmentsIntersect(s, segments[j], p)) return;
+      maps[id].insert(j);
+      maps[j].insert(id);
+      pairs++;
+    };
+    for (const BoxTree<T>& tree : trees) tree.query(box, test);
+    for (int j : tail)
+      if (box.overlaps(Box<T>::of(segments[j]))) test(j);
+
+    tail.push_back(id);
+    if (tail.size() == TAIL) flush();
+    return id;
+  }
+
+  // Removes segment id, false when it is not live
+  bool remove(int id) {
+    if (id < 0 || id >= (int)segments.size() || !live[id]) return false;
+    live[id] = false;
+    liveCount--;
+
+    auto it = maps.find(id);
+    if (it != maps.end()) {
+      for (int j : it->second) {
+        maps[j].erase(id);
+        if (maps[j].empty()) maps.erase(j);
+      }
+      pairs -= it->second.size();
+      maps.erase(it);
+    }
+
+    if (++stale > liveCount) rebuild();
+    return true;
+  }
+
+  // Current intersectionMaps over the live segments, keyed by id
+  const std::map<int, std::set<int>>& query() const { return maps; }
+
+  const BasicSegment<T>& segment(int id) const { return segments[id]; }
+  bool                   contains(int id) const { return id >= 0 && id < (int)segments.size() && live[id]; }
+  size_t                 size() const { return liveCount; }
+  size_t                 intersectionCount() const { return pairs; }
+
+  private:
+  std::vector<BasicSegment<T>> segments;
+  std::vector<bool>            live;
+  size_t                       liveCount = 0;
+  std::map<int, std::set<int>> maps;
+  size_t                       pairs = 0;
+  std::vector<BoxTree<T>>      trees;
+  std::vector<int>             tail;
+  size_t                       stale = 0; // removals since the last rebuild
+
+  // Turns the tail into a tree, merging the smaller trees above it and
+  // dropping removed segments on the way
+  void flush() {
+    std::vector<int> carry;
+    for (int j : tail)
+      if (live[j]) carry.push_back(j);
+    tail.clear();
+
+    while (!trees.empty() && trees.back().size() <= 2 * carry.size()) {
+      for (int j : trees.back().order())
+        if (live[j]) carry.push_back(j);
+      trees.pop_back();
+    }
+    if (!carry.empty()) trees.emplace_back(segments, std::move(carry));
+  }
+
+  void rebuild() {
+    std::vector<int> all;
+    for (int j = 0; j < (int)segments.size(); ++j)
+      if (live[j]) all.push_back(j);
+    trees.clear();
+    tail.clear();
+    stale = 0;
+    if (!all.empty()) trees.emplace_back(segments, std::move(all));
+  }
+};
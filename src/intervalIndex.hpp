@@ -0,0 +1,150 @@
+#pragma once
+#include "sweep.hpp"
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <vector>
+
+/**
+ * Static interval index over the x-extent of the segments.
+ *
+ * Segment ids are sorted by their low x and laid out in flat arrays; the
+ * implicit balanced tree over that array has the middle of [l, r) as the
+ * root of the range, and maxHigh[mid] / minHigh[mid] hold the largest and
+ * smallest high in [l, r). Built once in O(n log n), queried in
+ * O(log n + m) without recursion and without depending on the input order.
+ */
+template <typename T>
+class IntervalIndex {
+  public:
+  explicit IntervalIndex(const std::vector<BasicSegment<T>>& segments) :
+    IntervalIndex(segments, allIds(segments.size())) {}
+
+  // Index over a subset of the segments, search() reports the given ids
+  IntervalIndex(const std::vector<BasicSegment<T>>& segments, std::vector<int> subset) :
+    ids(std::move(subset)) {
+    int n = ids.size();
+    std::sort(ids.begin(), ids.end(), [&](int i, int j) {
+      return std::min(segments[i].a.x, segments[i].b.x) < std::min(segments[j].a.x, segments[j].b.x);
+    });
+
+    low.resize(n);
+    high.resize(n);
+    maxHigh.resize(n);
+    minHigh.resize(n);
+    for (int k = 0; k < n; ++k) {
+      const BasicSegment<T>& s = segments[ids[k]];
+      low[k]                   = std::min(s.a.x, s.b.x);
+      high[k]                  = std::max(s.a.x, s.b.x);
+    }
+    buildMaxHigh(0, n);
+    buildMinHigh(0, n);
+  }
+
+  // Appends the ids of all segments whose x-extent overlaps [qlow, qhigh];
+  // returns the number of tree nodes visited in SWEEP_STATS builds, else 0
+  size_t search(T qlow, T qhigh, std::vector<int>& result) const {
+    return searchPrefix(ids.size(), qlow, qhigh, result);
+  }
+
+  // Calls visit(begin, end) for the runs of entries before entry k whose
+  // x-extent overlaps it, in order and merged where adjacent; a subtree that
+  // overlaps it as a whole comes out as one run. Those entries start no
+  // later than entry k, so querying every k finds each overlapping pair once
+  template <typename Visit>
+  size_t runsBefore(int k, Visit visit) const {
+    struct Range {
+      int  l, r;
+      bool single;
+    };
+    Range  stack[128];
+    int    top     = 0;
+    size_t visited = 0;
+    T      qlow    = low[k] - tolerance<T>;
+    int    begin = 0, end = 0;
+    auto   emit = [&](int l, int r) {
+      if (l != end) {
+        if (end > begin) visit(begin, end);
+        begin = l;
+      }
+      end = r;
+    };
+    stack[top++] = {0, int(ids.size()), false};
+
+    while (top > 0) {
+      auto [l, r, single] = stack[--top];
+      if (single) {
+        emit(l, r);
+        continue;
+      }
+      if (l >= std::min(r, k)) continue;
+      SWEEP_STAT(visited++);
+
+      int mid = l + (r - l) / 2;
+      if (maxHigh[mid] < qlow) continue;
+      if (r <= k && minHigh[mid] >= qlow) {
+        emit(l, r);
+        continue;
+      }
+
+      // Left, middle, right in order, so pushed the other way round
+      stack[top++] = {mid + 1, r, false};
+      if (mid < k && high[mid] >= qlow) stack[top++] = {mid, mid + 1, true};
+      stack[top++] = {l, mid, false};
+    }
+    if (end > begin) visit(begin, end);
+    return visited;
+  }
+
+  // Entries in order of their low x
+  int size() const { return ids.size(); }
+  int id(int k) const { return ids[k]; }
+
+  private:
+  std::vector<int> ids;
+  std::vector<T>   low, high, maxHigh, minHigh;
+
+  // search() over the entries [0, end)
+  size_t searchPrefix(int end, T qlow, T qhigh, std::vector<int>& result) const {
+    std::pair<int, int> stack[64];
+    int                 top     = 0;
+    size_t              visited = 0;
+    stack[top++]                = {0, int(ids.size())};
+
+    while (top > 0) {
+      auto [l, r] = stack[--top];
+      if (l >= std::min(r, end)) continue;
+      SWEEP_STAT(visited++);
+
+      int mid = l + (r - l) / 2;
+      if (maxHigh[mid] < qlow - tolerance<T>) continue;
+
+      stack[top++] = {l, mid};
+      if (mid >= end || low[mid] > qhigh + tolerance<T>) continue;
+
+      if (high[mid] >= qlow - tolerance<T>) result.push_back(ids[mid]);
+      stack[top++] = {mid + 1, r};
+    }
+    return visited;
+  }
+
+  static std::vector<int> allIds(int n) {
+    std::vector<int> all(n);
+    std::iota(all.begin(), all.end(), 0);
+    return all;
+  }
+
+  T buildMaxHigh(int l, int r) {
+    if (l >= r) return std::numeric_limits<T>::lowest();
+    int mid      = l + (r - l) / 2;
+    maxHigh[mid] = std::max({high[mid], buildMaxHigh(l, mid), buildMaxHigh(mid + 1, r)});
+    return maxHigh[mid];
+  }
+
+  T buildMinHigh(int l, int r) {
+    if (l >= r) return std::numeric_limits<T>::max();
+    int mid      = l + (r - l) / 2;
+    minHigh[mid] = std::min({high[mid], buildMinHigh(l, mid), buildMinHigh(mid + 1, r)});
+    return minHigh[mid];
+  }
+};
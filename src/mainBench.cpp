@@ -0,0 +1,274 @@
+#include "sweep.hpp"
+#include "workload.hpp"
+#include "sweepSink.hpp"
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <string>
+#include <sys/resource.h>
+
+/**
+ * Scaling benchmark for the findIntersections* engines.
+ *
+ * Every (engine, generator) pair is run over N = minN, 10 * minN, ... maxN.
+ * Once a run exceeds the time budget the larger sizes of that series are
+ * skipped, so the O(n^2) engines drop out early while the sweeps keep going.
+ * One record per run is written to stdout as CSV (default) or JSON.
+ * With -file the engines run once over a binary segment dump instead.
+ * With -out every hit is also streamed to a binary hit file (FileSink),
+ * overwritten by each run. -coord runs the double or integer instantiation
+ * of the engines instead; integer coordinates are snapped to a grid of
+ * COORD_SCALE steps per unit before the clock starts. With -check every
+ * intersection count is compared with the tiled all-pairs engine on the
+ * same input, and mismatches are reported on stderr.
+ */
+
+inline constexpr double COORD_SCALE = 1 << 16;
+
+struct BenchConfig {
+  long                     minN    = 100;
+  long                     maxN    = 10000000;
+  double                   budget  = 5.0;
+  unsigned                 seed    = 42;
+  float                    domain  = 100.0f;
+  bool                     json    = false;
+  bool                     check   = false;
+  std::string              file;
+  std::string              out;
+  std::string              coord = "float";
+  ResultMode               mode  = ResultMode::Full;
+  std::vector<std::string> engines;
+  std::vector<std::string> generators;
+};
+
+struct BenchRecord {
+  std::string engine;
+  std::string generator;
+  long        n;
+  double      timeMs;
+  size_t      events;
+  size_t      intersections;
+  long        peakRssKb;
+};
+
+// Resets the kernel's high water mark so each run reports its own peak
+static bool resetPeakRss() {
+  std::ofstream clear("/proc/self/clear_refs");
+  if (!clear) return false;
+  clear << "5";
+  return bool(clear);
+}
+
+static long peakRssKb() {
+  std::ifstream status("/proc/self/status");
+  std::string   line;
+  while (std::getline(status, line)) {
+    if (line.rfind("VmHWM:", 0) == 0) return std::stol(line.substr(6));
+  }
+
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return usage.ru_maxrss;
+}
+
+static bool selected(const std::vector<std::string>& filter, const std::string& name) {
+  return filter.empty() || std::find(filter.begin(), filter.end(), name) != filter.end();
+}
+
+static void printRecord(const BenchRecord& r, bool json, bool first) {
+  if (json) {
+    std::cout << (first ? "  " : ",\n  ") << "{\"engine\": \"" << r.engine
+              << "\", \"generator\": \"" << r.generator << "\", \"n\": " << r.n
+              << ", \"time_ms\": " << r.timeMs << ", \"events\": " << r.events
+              << ", \"intersections\": " << r.intersections
+              << ", \"peak_rss_kb\": " << r.peakRssKb << "}";
+  } else {
+    std::cout << r.engine << "," << r.generator << "," << r.n << "," << r.timeMs << ","
+              << r.events << "," << r.intersections << "," << r.peakRssKb << std::endl;
+  }
+}
+
+template <typename T>
+const Engine<T> functions[] = {
+  findIntersectionsNaive<T>, findIntersections<T>, findIntersections2<T>, findIntersectionsInterval<T>,
+  findIntersectionsParallel<T>, findIntersectionsGrid<T>,
+  findIntersectionsLibrary<T>, findIntersectionsTiled<T>};
+
+template <typename T>
+static BenchRecord runOnce(Engine<T> function, BasicSweepinfo<T>& info, const std::string& out) {
+  resetPeakRss();
+
+  // Hit files hold float records
+  std::optional<FileSink> sink;
+  if constexpr (std::is_same_v<T, float>)
+    if (!out.empty()) info.sink = &sink.emplace(out);
+
+  auto                start  = std::chrono::steady_clock::now();
+  BasicSweepResult<T> result = function(info);
+  if (sink && !sink->close()) std::cerr << "Could not write hit file " << out << std::endl;
+  auto end  = std::chrono::steady_clock::now();
+  info.sink = nullptr;
+
+  BenchRecord record;
+  record.n             = info.segments.size();
+  record.timeMs        = std::chrono::duration<double, std::milli>(end - start).count();
+  record.events        = result.eventsProcessed;
+  record.intersections = result.intersectionCount;
+  record.peakRssKb     = peakRssKb();
+  return record;
+}
+
+// Runs engine e over info in the configured coordinate type
+static BenchRecord runEngine(int e, Sweepinfo& info, const BenchConfig& config) {
+  if (config.coord == "double") {
+    BasicSweepinfo<double> converted = convertSegments<double>(info);
+    return runOnce(functions<double>[e], converted, config.out);
+  }
+  if (config.coord == "int32") {
+    BasicSweepinfo<int32_t> converted = convertSegments<int32_t>(info, COORD_SCALE);
+    return runOnce(functions<int32_t>[e], converted, config.out);
+  }
+  if (config.coord == "int64") {
+    BasicSweepinfo<int64_t> converted = convertSegments<int64_t>(info, COORD_SCALE);
+    return runOnce(functions<int64_t>[e], converted, config.out);
+  }
+  return runOnce(functions<float>[e], info, config.out);
+}
+
+static void usage(const char* argv0) {
+  std::cerr << "Usage: " << argv0 << " [-json] [-minn N] [-maxn N] [-budget SECONDS] [-seed S]"
+            << " [-domain D] [-engine NAME]... [-gen NAME]... [-file SEGMENTS.bin]"
+            << " [-mode full|pairs|count|any|compact] [-out HITS.bin] [-coord float|double|int32|int64] [-check]\n";
+}
+
+int main(int argc, char** argv) {
+  BenchConfig config;
+
+  for (int i = 1; i < argc; i++) {
+    std::string arg  = argv[i];
+    bool        more = i + 1 < argc;
+    if (arg == "-json") config.json = true;
+    else if (arg == "-check") config.check = true;
+    else if (arg == "-minn" && more) config.minN = std::stol(argv[++i]);
+    else if (arg == "-maxn" && more) config.maxN = std::stol(argv[++i]);
+    else if (arg == "-budget" && more) config.budget = std::stod(argv[++i]);
+    else if (arg == "-seed" && more) config.seed = std::stoul(argv[++i]);
+    else if (arg == "-domain" && more) config.domain = std::stof(argv[++i]);
+    else if (arg == "-engine" && more) config.engines.push_back(argv[++i]);
+    else if (arg == "-gen" && more) config.generators.push_back(argv[++i]);
+    else if (arg == "-file" && more) config.file = argv[++i];
+    else if (arg == "-out" && more) config.out = argv[++i];
+    else if (arg == "-coord" && more) config.coord = argv[++i];
+    else if (arg == "-mode" && more) {
+      std::string mode = argv[++i];
+      if (mode == "full") config.mode = ResultMode::Full;
+      else if (mode == "pairs") config.mode = ResultMode::PairsOnly;
+      else if (mode == "count") config.mode = ResultMode::CountOnly;
+      else if (mode == "any") config.mode = ResultMode::AnyIntersection;
+      else if (mode == "compact") config.mode = ResultMode::Compact;
+      else {
+        usage(argv[0]);
+        return 1;
+      }
+    }
+    else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+
+  std::string functionsName[] = {
+    "findIntersectionsNaive", "findIntersections", "findIntersections2", "findIntersectionsInterval",
+    "findIntersectionsParallel", "findIntersectionsGrid",
+    "findIntersectionsLibrary", "findIntersectionsTiled"};
+
+  std::function<Sweepinfo(long n, unsigned seed, float domain)> generators[] = {
+    generateUniform, generateShort, generateLong, generateNearParallel, generateGrid};
+
+  std::string generatorsName[] = {
+    "uniform", "short", "long", "nearParallel", "grid"};
+
+  if (config.coord != "float" && config.coord != "double" && config.coord != "int32" && config.coord != "int64") {
+    usage(argv[0]);
+    return 1;
+  }
+  if (config.coord != "float" && !config.out.empty()) {
+    std::cerr << "-out needs float coordinates" << std::endl;
+    return 1;
+  }
+
+  // Oracle counts per (generator, n), generator -1 being the segment file
+  int                                    oracleEngine = std::find(std::begin(functionsName), std::end(functionsName), "findIntersectionsTiled") - std::begin(functionsName);
+  std::map<std::pair<int, long>, size_t> oracle;
+  auto                                   check = [&](const BenchRecord& record, int g, const Sweepinfo& info) {
+    if (!config.check) return;
+    auto key = std::make_pair(g, record.n);
+    if (!oracle.count(key)) {
+      Sweepinfo   counted = info;
+      BenchConfig quiet   = config;
+      counted.mode        = ResultMode::CountOnly;
+      quiet.out.clear();
+      oracle[key] = runEngine(oracleEngine, counted, quiet).intersections;
+    }
+
+    size_t expected = config.mode == ResultMode::AnyIntersection ? std::min<size_t>(oracle[key], 1) : oracle[key];
+    if (record.intersections != expected)
+      std::cerr << record.engine << "/" << record.generator << ": n=" << record.n << " found "
+                << record.intersections << " intersections, expected " << expected << std::endl;
+  };
+
+  if (config.json) std::cout << "[\n";
+  else std::cout << "engine,generator,n,time_ms,events,intersections,peak_rss_kb" << std::endl;
+
+  bool first = true;
+
+  if (!config.file.empty()) {
+    std::optional<Sweepinfo> info = loadSegments(config.file);
+    if (!info) {
+      std::cerr << "Could not load segment file " << config.file << std::endl;
+      return 1;
+    }
+    info->mode = config.mode;
+
+    for (int e = 0; e < std::size(functions<float>); e++) {
+      if (!selected(config.engines, functionsName[e])) continue;
+      BenchRecord record = runEngine(e, *info, config);
+      record.engine      = functionsName[e];
+      record.generator   = config.file;
+      printRecord(record, config.json, first);
+      check(record, -1, *info);
+      first = false;
+    }
+  }
+
+  for (int g = 0; g < std::size(generators) && config.file.empty(); g++) {
+    if (!selected(config.generators, generatorsName[g])) continue;
+
+    for (int e = 0; e < std::size(functions<float>); e++) {
+      if (!selected(config.engines, functionsName[e])) continue;
+
+      for (long n = config.minN; n <= config.maxN; n *= 10) {
+        Sweepinfo info     = generators[g](n, config.seed, config.domain);
+        info.mode          = config.mode;
+        BenchRecord record = runEngine(e, info, config);
+        record.engine      = functionsName[e];
+        record.generator   = generatorsName[g];
+
+        printRecord(record, config.json, first);
+        check(record, g, info);
+        first = false;
+
+        if (record.timeMs > config.budget * 1000.0) {
+          std::cerr << functionsName[e] << "/" << generatorsName[g] << ": over budget at n="
+                    << n << ", skipping larger sizes" << std::endl;
+          break;
+        }
+      }
+    }
+  }
+
+  if (config.json) std::cout << "\n]" << std::endl;
+}
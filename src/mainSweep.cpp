@@ -1,10 +1,18 @@
 #include "sweep.hpp"
+#include "workload.hpp"
+#include "sweepSink.hpp"
+#include "intersectionIndex.hpp"
+#include "redBlueIndex.hpp"
+#include "segmentIndex.hpp"
+#include "sweepCanonical.hpp"
 #include <iomanip>
 #include <iostream>
-#include <random>
 #include <stdlib.h>
 #include <math.h>
 #include <functional>
+#include <thread>
+#include <random>
+#include <set>
 
 
 #define RESET "\033[0m"
@@ -49,20 +57,8 @@ Sweepinfo test1() {
 }
 
 // Generate N points randomly and connect them one to one
-Sweepinfo test2(int n) {
-  std::vector<Segment> segments;
-
-  std::random_device                    rd;
-  std::mt19937                          gen(rd());
-  std::uniform_real_distribution<float> dis(0.0f, 100.0f);
-
-  for (int i = 0; i < n; ++i) {
-    Point a{dis(gen), dis(gen)};
-    Point b{dis(gen), dis(gen)};
-    segments.push_back(Segment{a, b});
-  }
-
-  return {.segments = std::move(segments)};
+Sweepinfo test2(int n, unsigned seed = 2) {
+  return generateUniform(n, seed);
 }
 
 // Same segment
@@ -85,6 +81,44 @@ Sweepinfo testDegenerate3() {
   return {{a, b}};
 }
 
+// Duplicated segment crossing a third one, each copy keeps its own index
+Sweepinfo testDegenerate4() {
+  Segment a = {{0, 0}, {4, 4}};
+  Segment b = {{0, 4}, {4, 0}};
+  return {{a, a, b}};
+}
+
+// Segment 2 starts on the vertical segment 1 at the x where segments 0 and
+// 1 cross, and crosses segment 3 right after
+Sweepinfo testCrossingAtInsert() {
+  return {{{{0, 4}, {9, 2}, 0}, {{3, 1}, {3, 7}, 1}, {{3, 4}, {8, 10}, 2}, {{4, 8}, {9, 5}, 3}, {{3, 7}, {6, 4}, 4}}};
+}
+
+// Segment 2 starts on segment 0 and crosses segment 1, so its insertion
+// finds a hit below and above it
+Sweepinfo testAnyNeighbours() {
+  return {{{{0, 0}, {10, 0}, 0}, {{0, 5}, {10, 5}, 1}, {{2, 0}, {4, 8}, 2}}};
+}
+
+// Endpoints on a side x side lattice of the given step: many crossings,
+// endpoints and vertical segments share an x. Without shared points no
+// endpoint is used twice, and verticals can be left out
+Sweepinfo testLattice(int n, unsigned seed, int side, float step, bool shared, bool verticals) {
+  std::mt19937                       rng(seed);
+  std::uniform_int_distribution<int> coord(0, side);
+  std::set<std::pair<int, int>>      used;
+  Sweepinfo                          info;
+  while (info.segments.size() < n) {
+    int x1 = coord(rng), y1 = coord(rng), x2 = coord(rng), y2 = coord(rng);
+    if ((x1 == x2 && y1 == y2) || (!verticals && x1 == x2)) continue;
+    if (!shared && (used.count({x1, y1}) || used.count({x2, y2}))) continue;
+    used.insert({x1, y1});
+    used.insert({x2, y2});
+    info.segments.emplace_back(Point{x1 * step, y1 * step}, Point{x2 * step, y2 * step}, int(info.segments.size()));
+  }
+  return info;
+}
+
 void cliSolution(const Sweepinfo& info, bool compare, std::function<SweepResult(const Sweepinfo& info)> function, bool showDifference = false) {
   SweepResult result = function(info);
 
@@ -125,16 +159,35 @@ void cliSolution(const Sweepinfo& info, bool compare, std::function<SweepResult(
     printResult(result);
 
   if (compare) {
-    auto naiveResult = findIntersectionsNaive(info);
-    bool same        = result == naiveResult;
-    if (same) {
+    auto expected = findIntersectionsTiled(info);
+    auto wanted   = canonicalOf(expected);
+    auto got      = canonicalOf(result);
+    if (got == wanted) {
       std::cout << GREEN << ">> Validation OK!!" << RESET << std::endl;
     } else {
+      CanonicalDiff<float> d = diff(wanted, got);
       std::cout << RED << ">> Validation ERROR!!      -> " << RESET;
-      std::cout << "Expected: " << naiveResult.intersectionPOints.size() << " Got: " << result.intersectionPOints.size() << std::endl;
+      std::cout << "Pairs missing: " << d.missingPairs.size() << " extra: " << d.extraPairs.size()
+                << ", points missing: " << d.missingPoints.size() << " extra: " << d.extraPoints.size() << std::endl;
+
+      // First differences only, unless asked for all of them
+      size_t limit     = verbose || showDifference ? SIZE_MAX : 10;
+      auto   listPairs = [&](const char* what, const std::vector<CanonicalPair>& pairs) {
+        for (size_t k = 0; k < std::min(limit, pairs.size()); ++k)
+          std::cout << "  " << what << " pair " << pairs[k].first << " " << pairs[k].second << std::endl;
+      };
+      auto listPoints = [&](const char* what, const std::vector<CanonicalCell>& cells) {
+        for (size_t k = 0; k < std::min(limit, cells.size()); ++k)
+          std::cout << "  " << what << " point (" << got.pointOf(cells[k]).x << ", " << got.pointOf(cells[k]).y << ")" << std::endl;
+      };
+      listPairs("missing", d.missingPairs);
+      listPairs("extra", d.extraPairs);
+      listPoints("missing", d.missingPoints);
+      listPoints("extra", d.extraPoints);
+
       if (verbose || showDifference) {
-        std::cout << "Naive Result:" << std::endl;
-        printResult(naiveResult);
+        std::cout << "Expected Result:" << std::endl;
+        printResult(expected);
         std::cout << "Result" << std::endl;
         printResult(result);
       }
@@ -142,34 +195,305 @@ void cliSolution(const Sweepinfo& info, bool compare, std::function<SweepResult(
   }
 }
 
+template <typename T>
+const Engine<T> functions[] = {
+  findIntersectionsNaive<T>, findIntersections<T>, findIntersections2<T>, findIntersectionsInterval<T>,
+  findIntersectionsParallel<T>, findIntersectionsGrid<T>,
+  findIntersectionsLibrary<T>, findIntersectionsTiled<T>};
+
+// Pairs found by an engine in coordinate type T against the tiled oracle in T
+template <typename T>
+bool samePairs(const Sweepinfo& info, int engine, double scale) {
+  BasicSweepinfo<T> converted = convertSegments<T>(info, scale);
+  converted.mode              = ResultMode::PairsOnly;
+  return canonicalOf(functions<T>[engine](converted)) == canonicalOf(findIntersectionsTiled(converted));
+}
+
+// Runs the double and integer instantiations of an engine
+void cliCoords(const Sweepinfo& info, int engine) {
+  bool same = samePairs<double>(info, engine, 1.0) && samePairs<int32_t>(info, engine, 1 << 16) &&
+    samePairs<int64_t>(info, engine, 1 << 24);
+
+  if (same) {
+    std::cout << GREEN << ">> Coords OK!!" << RESET << std::endl;
+  } else {
+    std::cout << RED << ">> Coords ERROR!!" << RESET << std::endl;
+  }
+}
+
+// Lattice inputs in float, double and snapped int32 against the oracle
+void cliLattice(int engine) {
+  bool same = true;
+  for (unsigned seed = 0; seed < 50 && same; ++seed) {
+    Sweepinfo sharedEnds = testLattice(40, seed, 10, 1.0f, true, true);
+    Sweepinfo distinct   = testLattice(40, seed, 10, 1.0f, false, false);
+    Sweepinfo fine       = testLattice(200, seed, 100, 0.1f, true, true);
+    same = samePairs<float>(sharedEnds, engine, 1.0) && samePairs<int32_t>(sharedEnds, engine, 1.0) &&
+      samePairs<float>(distinct, engine, 1.0) && samePairs<double>(distinct, engine, 1.0) &&
+      samePairs<float>(fine, engine, 1.0) && samePairs<int32_t>(fine, engine, 10.0);
+  }
+
+  if (same) {
+    std::cout << GREEN << ">> Lattice OK!!" << RESET << std::endl;
+  } else {
+    std::cout << RED << ">> Lattice ERROR!!" << RESET << std::endl;
+  }
+}
+
+// Runs the reduced result modes and checks them against the full result
+void cliModes(Sweepinfo info, std::function<SweepResult(const Sweepinfo& info)> function) {
+  SweepResult full = function(info);
+  info.mode        = ResultMode::PairsOnly;
+  SweepResult pairs = function(info);
+  info.mode         = ResultMode::CountOnly;
+  SweepResult count = function(info);
+  info.mode         = ResultMode::AnyIntersection;
+  SweepResult any   = function(info);
+
+  // Any mode hands at most one hit to the sink
+  size_t       anyEmitted = 0;
+  CallbackSink anySink([&](const IntersectionRecord&) {
+    anyEmitted++;
+    return true;
+  });
+  info.sink = &anySink;
+  function(info);
+  info.sink = nullptr;
+
+  info.mode         = ResultMode::Compact;
+  SweepResult flat  = function(info);
+
+  // The CSR lists hold exactly the map entries, in increasing order
+  const CompactResult& compact = flat.compact;
+  bool                 sameCsr = compact.segmentCount() == info.segments.size() && compact.records.size() == full.intersectionCount &&
+    flat.intersectionMaps.empty();
+  for (int i = 0; sameCsr && i < (int)compact.segmentCount(); ++i) {
+    auto hits = full.intersectionMaps.find(i);
+    sameCsr   = hits == full.intersectionMaps.end() ? compact.degree(i) == 0 :
+      std::equal(compact.begin(i), compact.end(i), hits->second.begin(), hits->second.end());
+    for (size_t k = 0; sameCsr && k < compact.degree(i); ++k) {
+      const IntersectionRecord& r = compact.record(i, k);
+      int                       j = compact.begin(i)[k];
+      sameCsr                     = (r.segA == i && r.segB == j) || (r.segA == j && r.segB == i);
+    }
+  }
+
+  // Streamed to a consumer thread through a small ring buffer
+  RingBufferSink ring(64);
+  size_t         streamed = 0;
+  std::thread    consumer([&] {
+    IntersectionRecord record;
+    while (ring.pop(record)) streamed++;
+  });
+  info.mode = ResultMode::CountOnly;
+  info.sink = &ring;
+  function(info);
+  ring.close();
+  consumer.join();
+
+  bool same = pairs.intersectionMaps == full.intersectionMaps && pairs.intersectionPOints.empty() &&
+    count.intersectionCount == full.intersectionCount && count.intersectionMaps.empty() &&
+    any.intersectionCount == (full.intersectionCount > 0 ? 1 : 0) && anyEmitted == any.intersectionCount && streamed == full.intersectionCount && sameCsr;
+
+  if (same) {
+    std::cout << GREEN << ">> Modes OK!!" << RESET << std::endl;
+  } else {
+    std::cout << RED << ">> Modes ERROR!!           -> " << RESET;
+    std::cout << "Full: " << full.intersectionCount << " Count: " << count.intersectionCount
+              << " Any: " << any.intersectionCount << " Any emitted: " << anyEmitted << " Streamed: " << streamed
+              << " Compact: " << compact.records.size() << std::endl;
+  }
+}
+
+// Full mode pieces: every hit segment in order from a to b, cut at each
+// distinct crossing inside it
+void cliSplit(const Sweepinfo& info, std::function<SweepResult(const Sweepinfo& info)> function) {
+  SweepResult result = function(info);
+  size_t      next   = 0;
+  bool        same   = true;
+  for (const auto& [i, hits] : result.intersectionMaps) {
+    const Segment&     s = info.segments[i];
+    std::vector<Point> cuts;
+    for (int j : hits) {
+      Point p;
+      if (segmentsIntersect(s, info.segments[j], p) && p != s.a && p != s.b &&
+          std::find(cuts.begin(), cuts.end(), p) == cuts.end())
+        cuts.push_back(p);
+    }
+
+    Point from = s.a;
+    for (size_t k = 0; same && k <= cuts.size(); ++k, ++next) {
+      same = next < result.intersectionSegments.size() && result.intersectionSegments[next].a == from &&
+        result.intersectionSegments[next].id == i;
+      if (same) from = result.intersectionSegments[next].b;
+    }
+    same = same && from == s.b;
+  }
+  same = same && next == result.intersectionSegments.size();
+
+  if (same) {
+    std::cout << GREEN << ">> Split OK!!" << RESET << std::endl;
+  } else {
+    std::cout << RED << ">> Split ERROR!!           -> " << RESET;
+    std::cout << "Pieces: " << result.intersectionSegments.size() << " checked: " << next << std::endl;
+  }
+}
+
+#ifdef SWEEP_STATS
+// Hot path counters of one run, zero for the engines not instrumented
+void cliStats(const Sweepinfo& info, Engine<float> function) {
+  SweepStats stats = function(info).stats;
+  std::cout << "events " << stats.insertEvents << "/" << stats.removeEvents << "/" << stats.crossingEvents
+            << " compares " << stats.comparatorCalls << " tests " << stats.pairTests
+            << " duplicates " << stats.duplicateSchedules << " status " << stats.maxStatusSize
+            << " queue " << stats.maxQueueSize << " nodes " << stats.intervalNodesVisited << std::endl;
+}
+#endif
+
+// Builds an index over half of info, inserts the rest and removes two
+// thirds of everything, then checks the map against the tiled oracle run on
+// the segments left
+void cliIndex(const Sweepinfo& info) {
+  size_t                   half = info.segments.size() / 2;
+  IntersectionIndex<float> index({info.segments.begin(), info.segments.begin() + half});
+  for (size_t i = half; i < info.segments.size(); ++i) index.insert(info.segments[i]);
+  for (int id = 0; id < (int)info.segments.size(); ++id)
+    if (id % 3 != 0) index.remove(id);
+
+  Sweepinfo        rest;
+  std::vector<int> ids;
+  for (int id = 0; id < (int)info.segments.size(); ++id) {
+    if (!index.contains(id)) continue;
+    rest.segments.push_back(index.segment(id));
+    ids.push_back(id);
+  }
+  rest.mode = ResultMode::PairsOnly;
+
+  std::map<int, std::set<int>> expected;
+  for (const auto& [i, hits] : findIntersectionsTiled(rest).intersectionMaps)
+    for (int j : hits) expected[ids[i]].insert(ids[j]);
+
+  if (index.query() == expected) {
+    std::cout << GREEN << ">> Index OK!!" << RESET << std::endl;
+  } else {
+    std::cout << RED << ">> Index ERROR!!" << RESET << std::endl;
+  }
+}
+
+// Crosses the first quarter of info (red) with the rest (blue) and checks
+// the red-blue pairs against the tiled oracle run on everything
+void cliRedBlue(const Sweepinfo& info) {
+  int                 reds = info.segments.size() / 4;
+  Sweepinfo           red;
+  RedBlueIndex<float> index({info.segments.begin() + reds, info.segments.end()});
+  red.segments.assign(info.segments.begin(), info.segments.begin() + reds);
+  red.mode = ResultMode::PairsOnly;
+
+  Sweepinfo all = info;
+  all.mode      = ResultMode::PairsOnly;
+  std::map<int, std::set<int>> expected;
+  for (const auto& [i, hits] : findIntersectionsTiled(all).intersectionMaps)
+    for (int j : hits)
+      if (i < reds && j >= reds) expected[i].insert(j - reds);
+
+  SweepResult pairs = index.intersect(red);
+  red.mode          = ResultMode::CountOnly;
+  SweepResult count = index.intersect(red);
+
+  if (pairs.intersectionMaps == expected && count.intersectionCount == pairs.intersectionCount) {
+    std::cout << GREEN << ">> RedBlue OK!!" << RESET << std::endl;
+  } else {
+    std::cout << RED << ">> RedBlue ERROR!!" << RESET << std::endl;
+  }
+}
+
+// Batched segment and box probes against brute force over every segment
+void cliQueries(const Sweepinfo& info, const Sweepinfo& probes) {
+  SegmentIndex<float>     index(info.segments);
+  std::vector<Box<float>> boxes;
+  for (const Segment& s : probes.segments) boxes.push_back(Box<float>::of(s));
+
+  QueryHits bySegment = index.hits(probes.segments);
+  QueryHits byBox     = index.hits(boxes);
+
+  bool same = bySegment.size() == probes.segments.size() && byBox.size() == boxes.size();
+  for (size_t q = 0; same && q < probes.segments.size(); ++q) {
+    std::vector<int> segmentHits, boxHits;
+    for (int j = 0; j < (int)info.segments.size(); ++j) {
+      Point p;
+      if (segmentsIntersect(probes.segments[q], info.segments[j], p)) segmentHits.push_back(j);
+      if (boxes[q].crossedBy(info.segments[j])) boxHits.push_back(j);
+    }
+    same = std::equal(segmentHits.begin(), segmentHits.end(), bySegment.begin(q), bySegment.end(q)) &&
+      segmentHits.size() == size_t(bySegment.end(q) - bySegment.begin(q)) &&
+      std::equal(boxHits.begin(), boxHits.end(), byBox.begin(q), byBox.end(q)) &&
+      boxHits.size() == size_t(byBox.end(q) - byBox.begin(q));
+  }
+
+  if (same) {
+    std::cout << GREEN << ">> Queries OK!!" << RESET << std::endl;
+  } else {
+    std::cout << RED << ">> Queries ERROR!!" << RESET << std::endl;
+  }
+}
+
 int main(int argc, char** argv) {
   if (argc > 1 && std::string(argv[1]) == "-verbose") {
     verbose = true;
   }
 
-  int count = 4;
-
-  std::function<SweepResult(const Sweepinfo& info)> functions[] = {
-    findIntersectionsNaive, findIntersections, findIntersections2, findIntersectionsInterval};
-
   std::string functionsName[] = {
-    "findIntersectionsNaive", "findIntersections", "findIntersections2", "findIntersectionsInterval"};
+    "findIntersectionsNaive", "findIntersections", "findIntersections2", "findIntersectionsInterval",
+    "findIntersectionsParallel", "findIntersectionsGrid",
+    "findIntersectionsLibrary", "findIntersectionsTiled"};
 
 
-  for (int i = 0; i < count; i++) {
+  for (int i = 0; i < std::size(functions<float>); i++) {
     std::cout << "Probing: " << functionsName[i] << std::endl;
     std::cout << "test0\t";
-    cliSolution(test0(), true, functions[i]);
+    cliSolution(test0(), true, functions<float>[i]);
     std::cout << "test1\t";
-    cliSolution(test1(), true, functions[i]);
+    cliSolution(test1(), true, functions<float>[i]);
     std::cout << "degenerate1\t";
-    cliSolution(testDegenerate1(), true, functions[i]);
+    cliSolution(testDegenerate1(), true, functions<float>[i]);
     std::cout << "degenerate2\t";
-    cliSolution(testDegenerate2(), true, functions[i]);
+    cliSolution(testDegenerate2(), true, functions<float>[i]);
     std::cout << "degenerate3\t";
-    cliSolution(testDegenerate3(), true, functions[i]);
+    cliSolution(testDegenerate3(), true, functions<float>[i]);
+    std::cout << "degenerate4\t";
+    cliSolution(testDegenerate4(), true, functions<float>[i]);
+    std::cout << "crossing\t";
+    cliSolution(testCrossingAtInsert(), true, functions<float>[i]);
     std::cout << "test2\t";
-    cliSolution(test2(200), true, functions[i]);
+    cliSolution(test2(200), true, functions<float>[i]);
+    std::cout << "lattice\t";
+    cliLattice(i);
+    std::cout << "modes\t";
+    cliModes(test2(200), functions<float>[i]);
+    std::cout << "modes\t";
+    cliModes(testAnyNeighbours(), functions<float>[i]);
+    std::cout << "split\t";
+    cliSplit(test0(), functions<float>[i]);
+    std::cout << "split\t";
+    cliSplit(test2(200), functions<float>[i]);
+    std::cout << "coords\t";
+    cliCoords(test2(200), i);
+#ifdef SWEEP_STATS
+    std::cout << "stats\t";
+    cliStats(test2(200), functions<float>[i]);
+#endif
     std::cout << std::endl;
   }
+
+  std::cout << "Probing: IntersectionIndex" << std::endl;
+  std::cout << "edits\t";
+  cliIndex(test2(400));
+
+  std::cout << "Probing: RedBlueIndex" << std::endl;
+  std::cout << "layers\t";
+  cliRedBlue(test2(400));
+
+  std::cout << "Probing: SegmentIndex" << std::endl;
+  std::cout << "batch\t";
+  cliQueries(test2(400), test2(100, 5));
 }
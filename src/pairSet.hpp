@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * Open addressing hash set of unordered segment index pairs.
+ *
+ * A pair (i, j) is packed into a single 64 bit key (min << 32 | max) and
+ * stored inline in a power of two table with linear probing, so lookups
+ * touch one or two cache lines and never allocate. insert() doubles as the
+ * lookup: it returns false when the pair was already present.
+ */
+class PairSet {
+  public:
+  explicit PairSet(size_t expected = 0) { reserve(expected); }
+
+  // Makes room for expected pairs without rehashing (load factor <= 1/2)
+  void reserve(size_t expected) {
+    size_t capacity = 16;
+    while (capacity < 2 * expected) capacity <<= 1;
+    if (capacity > slots.size()) rehash(capacity);
+  }
+
+  bool insert(int i, int j) {
+    if (2 * (count + 1) > slots.size()) rehash(2 * slots.size());
+
+    uint64_t k = key(i, j);
+    for (size_t s = hash(k) & mask;; s = (s + 1) & mask) {
+      if (slots[s] == k) return false;
+      if (slots[s] == EMPTY) {
+        slots[s] = k;
+        count++;
+        return true;
+      }
+    }
+  }
+
+  bool contains(int i, int j) const {
+    uint64_t k = key(i, j);
+    for (size_t s = hash(k) & mask;; s = (s + 1) & mask) {
+      if (slots[s] == k) return true;
+      if (slots[s] == EMPTY) return false;
+    }
+  }
+
+  size_t size() const { return count; }
+
+  private:
+  static constexpr uint64_t EMPTY = ~uint64_t(0);
+
+  std::vector<uint64_t> slots;
+  size_t                count = 0;
+  size_t                mask  = 0;
+
+  static uint64_t key(int i, int j) {
+    if (i > j) std::swap(i, j);
+    return (uint64_t(uint32_t(i)) << 32) | uint32_t(j);
+  }
+
+  // splitmix64 finalizer, spreads the packed indices over the low bits
+  static uint64_t hash(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+  }
+
+  void rehash(size_t capacity) {
+    std::vector<uint64_t> old(capacity, EMPTY);
+    old.swap(slots);
+    mask = capacity - 1;
+    for (uint64_t k : old) {
+      if (k == EMPTY) continue;
+      size_t s = hash(k) & mask;
+      while (slots[s] != EMPTY) s = (s + 1) & mask;
+      slots[s] = k;
+    }
+  }
+};
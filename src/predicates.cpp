@@ -0,0 +1,174 @@
+#include "predicates.hpp"
+#include <cmath>
+#include <vector>
+
+static constexpr double ORIENT_DOUBLE_BOUND = orientBound<double>;
+
+// a + b = x + y exactly, with |y| <= ulp(x) / 2
+static inline void twoSum(double a, double b, double& x, double& y) {
+  x         = a + b;
+  double bv = x - a;
+  double av = x - bv;
+  y         = (a - av) + (b - bv);
+}
+
+// a * b = x + y exactly
+static inline void twoProduct(double a, double b, double& x, double& y) {
+  x = a * b;
+  y = std::fma(a, b, -x);
+}
+
+/**
+ * Exact sign of sum(a[k] * b[k]). Every product is split into a two term
+ * expansion and accumulated with Grow-Expansion; the components stay
+ * nonoverlapping and sorted by magnitude, so the sign of the sum is the
+ * sign of the largest nonzero component.
+ */
+static int sumOfProductsSign(const double* a, const double* b, int n) {
+  double expansion[64];
+  int    length = 0;
+
+  auto grow = [&](double value) {
+    double q = value;
+    int    m = 0;
+    for (int k = 0; k < length; ++k) {
+      double h;
+      twoSum(q, expansion[k], q, h);
+      if (h != 0) expansion[m++] = h;
+    }
+    if (q != 0) expansion[m++] = q;
+    length = m;
+  };
+
+  for (int k = 0; k < n; ++k) {
+    double p, e;
+    twoProduct(a[k], b[k], p, e);
+    grow(e);
+    grow(p);
+  }
+
+  if (length == 0) return 0;
+  return expansion[length - 1] > 0 ? 1 : -1;
+}
+
+double orient2d(double ax, double ay, double bx, double by, double cx, double cy) {
+  double detleft  = (ax - cx) * (by - cy);
+  double detright = (ay - cy) * (bx - cx);
+  double det      = detleft - detright;
+
+  if (std::fabs(det) > ORIENT_DOUBLE_BOUND * (std::fabs(detleft) + std::fabs(detright)))
+    return det;
+
+  // (ax - cx)(by - cy) - (ay - cy)(bx - cx) expanded on the raw coordinates,
+  // the cx * cy terms cancel
+  const double a[6] = {ax, -ax, -cx, -ay, ay, cy};
+  const double b[6] = {by, cy, by, bx, cx, bx};
+  return sumOfProductsSign(a, b, 6);
+}
+
+int crossSign(double ax1, double ay1, double bx1, double by1, double ax2, double ay2, double bx2, double by2) {
+  double left  = (bx1 - ax1) * (by2 - ay2);
+  double right = (by1 - ay1) * (bx2 - ax2);
+  double det   = left - right;
+
+  if (std::fabs(det) > ORIENT_DOUBLE_BOUND * (std::fabs(left) + std::fabs(right)))
+    return det > 0 ? 1 : -1;
+
+  // (bx1 - ax1)(by2 - ay2) - (by1 - ay1)(bx2 - ax2) expanded
+  const double a[8] = {bx1, -bx1, -ax1, ax1, -by1, by1, ay1, -ay1};
+  const double b[8] = {by2, ay2, by2, ay2, bx2, ax2, bx2, ax2};
+  return sumOfProductsSign(a, b, 8);
+}
+
+static inline int sign(double v) {
+  return (v > 0) - (v < 0);
+}
+
+bool segmentsCrossExact(double ax1, double ay1, double bx1, double by1, double ax2, double ay2, double bx2, double by2) {
+  int o1 = sign(orient2d(ax1, ay1, bx1, by1, ax2, ay2));
+  int o2 = sign(orient2d(ax1, ay1, bx1, by1, bx2, by2));
+  if (o1 == 0 && o2 == 0) return false;
+  if (o1 * o2 > 0) return false;
+
+  int o3 = sign(orient2d(ax2, ay2, bx2, by2, ax1, ay1));
+  int o4 = sign(orient2d(ax2, ay2, bx2, by2, bx1, by1));
+  return o3 * o4 <= 0;
+}
+
+/**
+ * Exact value as a nonoverlapping expansion, components sorted by
+ * magnitude and zeros dropped. Grown one double at a time, which keeps the
+ * code short; only the inconclusive crossing comparisons get here.
+ */
+namespace {
+  struct Expansion {
+    std::vector<double> terms;
+
+    void grow(double value) {
+      double q = value;
+      size_t m = 0;
+      for (size_t k = 0; k < terms.size(); ++k) {
+        double h;
+        twoSum(q, terms[k], q, h);
+        if (h != 0) terms[m++] = h;
+      }
+      terms.resize(m);
+      if (q != 0) terms.push_back(q);
+    }
+
+    int sign() const { return terms.empty() ? 0 : terms.back() > 0 ? 1 : -1; }
+  };
+
+  Expansion of(SplitCoord c) {
+    Expansion e;
+    e.grow(c.lo);
+    e.grow(c.hi);
+    return e;
+  }
+
+  Expansion operator+(Expansion e, const Expansion& f) {
+    for (double v : f.terms) e.grow(v);
+    return e;
+  }
+
+  Expansion operator-(Expansion e, const Expansion& f) {
+    for (double v : f.terms) e.grow(-v);
+    return e;
+  }
+
+  Expansion operator*(const Expansion& e, const Expansion& f) {
+    Expansion product;
+    for (double a : e.terms)
+      for (double b : f.terms) {
+        double p, q;
+        twoProduct(a, b, p, q);
+        product.grow(q);
+        product.grow(p);
+      }
+    return product;
+  }
+
+  // X = num / den for the lines through 1-2 and 3-4
+  void lineCrossing(const SplitCoord* l, Expansion& num, Expansion& den) {
+    Expansion x1 = of(l[0]), y1 = of(l[1]), x2 = of(l[2]), y2 = of(l[3]);
+    Expansion x3 = of(l[4]), y3 = of(l[5]), x4 = of(l[6]), y4 = of(l[7]);
+    Expansion dx1 = x2 - x1, dy1 = y2 - y1, dx2 = x4 - x3, dy2 = y4 - y3;
+
+    den           = dx1 * dy2 - dy1 * dx2;
+    Expansion off = (x3 - x1) * dy2 - (y3 - y1) * dx2;
+    num           = x1 * den + dx1 * off;
+  }
+} // namespace
+
+int crossingXSign(const SplitCoord lines[8], SplitCoord x) {
+  Expansion num, den;
+  lineCrossing(lines, num, den);
+  return (num - of(x) * den).sign() * den.sign();
+}
+
+int crossingXOrder(const SplitCoord first[8], const SplitCoord second[8]) {
+  Expansion num1, den1, num2, den2;
+  lineCrossing(first, num1, den1);
+  lineCrossing(second, num2, den2);
+  return (num1 * den2 - num2 * den1).sign() * den1.sign() * den2.sign();
+}
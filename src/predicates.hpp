@@ -0,0 +1,121 @@
+#pragma once
+#include <cstdint>
+#include <type_traits>
+
+/**
+ * Adaptive precision geometric predicates (after Shewchuk).
+ *
+ * Each predicate is first evaluated in double precision together with a
+ * forward error bound; only when the result is within the bound it is
+ * recomputed exactly with floating point expansion arithmetic. The sign of
+ * every result is exact for any float or double input (barring overflow
+ * and underflow).
+ */
+
+// > 0 when c lies left of a->b (counterclockwise), < 0 right of it, 0 on it
+double orient2d(double ax, double ay, double bx, double by, double cx, double cy);
+
+// Exact sign of the cross product of the directions (b1 - a1) x (b2 - a2)
+int crossSign(double ax1, double ay1, double bx1, double by1, double ax2, double ay2, double bx2, double by2);
+
+// Closed segments a1-b1 and a2-b2 share exactly one point; collinear
+// segments never do
+bool segmentsCrossExact(double ax1, double ay1, double bx1, double by1, double ax2, double ay2, double bx2, double by2);
+
+/**
+ * Order along x of the points where two lines meet, for the sweep events.
+ * A line pair is given as (x1, y1, x2, y2, x3, y3, x4, y4) for the lines
+ * through 1-2 and 3-4, which must not be parallel. Coordinates come as hi +
+ * lo double pairs so that int64 values beyond 2^53 stay exact. Both
+ * predicates go straight to expansion arithmetic; callers filter with an
+ * interval around the abscissa first (crossingBounds in sweepKernel.hpp).
+ */
+struct SplitCoord {
+  double hi, lo;
+};
+
+// Sign of X - x, X being the abscissa where the lines meet
+int crossingXSign(const SplitCoord lines[8], SplitCoord x);
+
+// Sign of X1 - X2 for two line pairs
+int crossingXOrder(const SplitCoord first[8], const SplitCoord second[8]);
+
+template <typename T>
+inline SplitCoord splitCoord(T v) {
+  if constexpr (std::is_same_v<T, int64_t>) {
+    // hi keeps the upper 32 bits, lo in [0, 2^32), both exact doubles
+    int64_t hi = v & ~int64_t(0xFFFFFFFF);
+    return {double(hi), double(v - hi)};
+  } else {
+    return {double(v), 0.0};
+  }
+}
+
+/**
+ * Error bound of the orient2d fast path evaluated in T arithmetic:
+ * |det| > orientBound<T> * (|detleft| + |detright|) certifies its sign.
+ * This is Shewchuk's ccwerrboundA = (3 + 16u) u, u being the unit roundoff.
+ */
+template <typename T>
+inline constexpr T orientBound = T(0);
+template <>
+inline constexpr float orientBound<float> = 1.7881400e-7f;
+template <>
+inline constexpr double orientBound<double> = (3.0 + 16.0 * 0x1p-53) * 0x1p-53;
+
+/**
+ * Integer coordinates are decided with plain 128 bit arithmetic, no filter
+ * needed. int64 coordinates must stay within +-2^62 for the products to fit.
+ */
+namespace exact {
+  inline int sign(__int128 v) {
+    return (v > 0) - (v < 0);
+  }
+
+  template <typename T>
+  inline int orient(T ax, T ay, T bx, T by, T cx, T cy) {
+    __int128 l = (__int128(ax) - cx) * (__int128(by) - cy);
+    __int128 r = (__int128(ay) - cy) * (__int128(bx) - cx);
+    return sign(l - r);
+  }
+} // namespace exact
+
+// Sign of orient2d for any coordinate type
+template <typename T>
+inline int orientSign(T ax, T ay, T bx, T by, T cx, T cy) {
+  if constexpr (std::is_integral_v<T>) {
+    return exact::orient(ax, ay, bx, by, cx, cy);
+  } else {
+    double det = orient2d(ax, ay, bx, by, cx, cy);
+    return (det > 0) - (det < 0);
+  }
+}
+
+// crossSign for any coordinate type
+template <typename T>
+inline int crossSignOf(T ax1, T ay1, T bx1, T by1, T ax2, T ay2, T bx2, T by2) {
+  if constexpr (std::is_integral_v<T>) {
+    __int128 l = (__int128(bx1) - ax1) * (__int128(by2) - ay2);
+    __int128 r = (__int128(by1) - ay1) * (__int128(bx2) - ax2);
+    return exact::sign(l - r);
+  } else {
+    return crossSign(ax1, ay1, bx1, by1, ax2, ay2, bx2, by2);
+  }
+}
+
+// segmentsCrossExact for any coordinate type
+template <typename T>
+inline bool segmentsCross(T ax1, T ay1, T bx1, T by1, T ax2, T ay2, T bx2, T by2) {
+  if constexpr (std::is_integral_v<T>) {
+    int o1 = orientSign(ax1, ay1, bx1, by1, ax2, ay2);
+    int o2 = orientSign(ax1, ay1, bx1, by1, bx2, by2);
+    if (o1 == 0 && o2 == 0) return false;
+    if (o1 * o2 > 0) return false;
+
+    int o3 = orientSign(ax2, ay2, bx2, by2, ax1, ay1);
+    int o4 = orientSign(ax2, ay2, bx2, by2, bx1, by1);
+    return o3 * o4 <= 0;
+  } else {
+    return segmentsCrossExact(ax1, ay1, bx1, by1, ax2, ay2, bx2, by2);
+  }
+}
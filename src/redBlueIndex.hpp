@@ -0,0 +1,59 @@
+#pragma once
+#include "sweep.hpp"
+#include "segmentIndex.hpp"
+#include "sweepReport.hpp"
+
+/**
+ * Bichromatic (red-blue) intersection against a fixed base layer.
+ *
+ * The blue segments are indexed once (SegmentIndex); intersect() then
+ * streams a red Sweepinfo against it and reports only red-blue pairs, so
+ * the cost follows the red set and the blue boxes it touches, never the
+ * crossings inside the blue layer. Red segments are not tested against
+ * each other.
+ *
+ * Results use red ids as keys: intersectionMaps maps a red segment to the
+ * blue ones it crosses, and records streamed to the sink carry
+ * (red, blue) in that order.
+ */
+template <typename T>
+class RedBlueIndex {
+  public:
+  explicit RedBlueIndex(std::vector<BasicSegment<T>> blue) :
+    index(std::move(blue)) {}
+
+  const std::vector<BasicSegment<T>>& segments() const { return index.segments(); }
+
+  BasicSweepResult<T> intersect(const BasicSweepinfo<T>& red) const {
+    BasicSweepResult<T>                result;
+    HitReporter                        reporter(red, result);
+    typename SegmentIndex<T>::Scratch scratch;
+    BasicCompactResult<T>              redCuts, blueCuts;
+
+    for (int i = 0; i < (int)red.segments.size() && !reporter.stopped(); ++i) {
+      result.eventsProcessed += index.probe(red.segments[i], scratch, [&](int j, BasicPoint<T> ip) {
+        if (reporter.stopped()) return;
+        reporter.addRedBlue(i, j, ip);
+        if (!reporter.full()) return;
+        redCuts.records.push_back({i, j, ip});
+        blueCuts.records.push_back({j, i, ip});
+      });
+    }
+
+    // Both layers are split at their crossings, red pieces first; piece ids
+    // index the layer a piece was cut from
+    if (reporter.full()) {
+      redCuts.build(red.segments.size(), false);
+      blueCuts.build(index.segments().size(), false);
+      result.intersectionSegments       = splitSegments(red.segments, redCuts, false);
+      std::vector<BasicSegment<T>> blue = splitSegments(index.segments(), blueCuts, false);
+      result.intersectionSegments.insert(result.intersectionSegments.end(), blue.begin(), blue.end());
+    }
+
+    reporter.finish();
+    return result;
+  }
+
+  private:
+  SegmentIndex<T> index;
+};
@@ -0,0 +1,175 @@
+#pragma once
+#include "sweep.hpp"
+#include "boxTree.hpp"
+#include "sweepKernel.hpp"
+#include <cstdint>
+#include <numeric>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+// Answers of a query batch in flat arrays: ids[start[q], start[q + 1]) are
+// the segments hit by query q, in increasing order
+struct QueryHits {
+  std::vector<size_t> start;
+  std::vector<int>    ids;
+
+  size_t     size() const { return start.empty() ? 0 : start.size() - 1; }
+  const int* begin(size_t q) const { return ids.data() + start[q]; }
+  const int* end(size_t q) const { return ids.data() + start[q + 1]; }
+};
+
+/**
+ * Immutable segment index answering "which segments does this probe hit".
+ *
+ * Built once over a fixed segment set (a packed BoxTree), then never
+ * modified: every query method is const and keeps its state on the stack
+ * or in a caller owned Scratch, so any number of threads may query one
+ * index concurrently. A probe
+ * segment hits the segments it crosses, decided exactly like the engines
+ * do; a probe box hits the segments meeting the closed box.
+ *
+ * The batched overloads sort the queries along a Morton curve over the
+ * index bounds, so consecutive queries walk the same nodes, and answer
+ * them in parallel with per thread buffers gathered into one QueryHits.
+ */
+template <typename T>
+class SegmentIndex {
+  public:
+  explicit SegmentIndex(std::vector<BasicSegment<T>> segments) :
+    indexed(std::move(segments)), tree(indexed) {}
+
+  const std::vector<BasicSegment<T>>& segments() const { return indexed; }
+
+  // Per thread buffers of segment probes, owned by the caller so that the
+  // index itself stays read only
+  struct Scratch {
+    std::vector<int>   candidates;
+    BasicSegmentSoA<T> soa;
+    BasicKernelHits<T> hits;
+  };
+
+  // Calls visit(id, point) for every segment crossed by query and returns
+  // the number of candidates tested
+  template <typename Visit>
+  size_t probe(const BasicSegment<T>& query, Scratch& scratch, Visit&& visit) const {
+    std::vector<int>& candidates = scratch.candidates;
+    candidates.clear();
+    tree.query(Box<T>::of(query), [&](int j) { candidates.push_back(j); });
+    scratch.soa.gather(indexed, candidates.data(), candidates.size());
+
+    for (int block = 0; block < (int)candidates.size(); block += KERNEL_BLOCK) {
+      intersectBlock(query, scratch.soa, block, std::min<int>(KERNEL_BLOCK, candidates.size() - block), scratch.hits);
+      for (uint64_t mask = scratch.hits.mask; mask; mask &= mask - 1) {
+        int k = __builtin_ctzll(mask);
+        visit(candidates[block + k], BasicPoint<T>{scratch.hits.px[k], scratch.hits.py[k]});
+      }
+    }
+    return candidates.size();
+  }
+
+  template <typename Visit>
+  size_t probe(const BasicSegment<T>& query, Visit&& visit) const {
+    Scratch scratch;
+    return probe(query, scratch, visit);
+  }
+
+  // Calls visit(id) for every segment meeting box
+  template <typename Visit>
+  void probe(const Box<T>& box, Visit&& visit) const {
+    tree.query(box, [&](int j) {
+      if (box.crossedBy(indexed[j])) visit(j);
+    });
+  }
+
+  QueryHits hits(const std::vector<BasicSegment<T>>& probes) const {
+    return batch(probes, [&](const BasicSegment<T>& s, Scratch& scratch, std::vector<int>& out) {
+      probe(s, scratch, [&](int j, BasicPoint<T>) { out.push_back(j); });
+    });
+  }
+
+  QueryHits hits(const std::vector<Box<T>>& boxes) const {
+    return batch(boxes, [&](const Box<T>& b, Scratch&, std::vector<int>& out) {
+      probe(b, [&](int j) { out.push_back(j); });
+    });
+  }
+
+  private:
+  std::vector<BasicSegment<T>> indexed;
+  BoxTree<T>                   tree;
+
+  static Box<T> boxOf(const BasicSegment<T>& s) { return Box<T>::of(s); }
+  static Box<T> boxOf(const Box<T>& b) { return b; }
+
+  // Interleaves 16 bit cells of the query center within the index bounds
+  uint32_t mortonOf(const Box<T>& b) const {
+    const Box<T>& all  = tree.bounds();
+    auto          cell = [](double v, double lo, double hi) {
+      double t = hi > lo ? (v - lo) / (hi - lo) : 0;
+      return uint32_t(std::clamp(t, 0.0, 1.0) * 65535);
+    };
+    auto spread = [](uint32_t v) {
+      v = (v | (v << 8)) & 0x00ff00ffu;
+      v = (v | (v << 4)) & 0x0f0f0f0fu;
+      v = (v | (v << 2)) & 0x33333333u;
+      v = (v | (v << 1)) & 0x55555555u;
+      return v;
+    };
+    return spread(cell(b.centerX(), double(all.minX), double(all.maxX))) |
+      (spread(cell(b.centerY(), double(all.minY), double(all.maxY))) << 1);
+  }
+
+  template <typename Query, typename Answer>
+  QueryHits batch(const std::vector<Query>& queries, Answer answer) const {
+    size_t    q = queries.size();
+    QueryHits hits;
+    hits.start.assign(q + 1, 0);
+    if (q == 0 || tree.size() == 0) return hits;
+
+    std::vector<uint32_t> keys(q);
+    std::vector<size_t>   order(q);
+    for (size_t k = 0; k < q; ++k) keys[k] = mortonOf(boxOf(queries[k]));
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t l, size_t r) { return keys[l] < keys[r]; });
+
+    int threads = 1;
+#ifdef _OPENMP
+    threads = omp_get_max_threads();
+#endif
+    // Answers land in the buffer of whichever thread ran the query
+    std::vector<std::vector<int>> local(threads);
+    std::vector<size_t>           first(q);
+    std::vector<int>              owner(q);
+
+#pragma omp parallel
+    {
+      int thread = 0;
+#ifdef _OPENMP
+      thread = omp_get_thread_num();
+#endif
+      std::vector<int>& out = local[thread];
+      Scratch           scratch;
+
+#pragma omp for schedule(dynamic, 256)
+      for (size_t r = 0; r < q; ++r) {
+        size_t k = order[r];
+        first[k] = out.size();
+        owner[k] = thread;
+        answer(queries[k], scratch, out);
+        hits.start[k + 1] = out.size() - first[k];
+      }
+    }
+
+    for (size_t k = 0; k < q; ++k) hits.start[k + 1] += hits.start[k];
+    hits.ids.resize(hits.start[q]);
+
+#pragma omp parallel for schedule(dynamic, 256)
+    for (size_t k = 0; k < q; ++k) {
+      const int* from = local[owner[k]].data() + first[k];
+      int*       to   = hits.ids.data() + hits.start[k];
+      std::copy(from, from + (hits.start[k + 1] - hits.start[k]), to);
+      std::sort(to, hits.ids.data() + hits.start[k + 1]);
+    }
+    return hits;
+  }
+};
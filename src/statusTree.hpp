@@ -0,0 +1,204 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Sweep status structure: a treap over segment ids, threaded with prev/next
+ * links in sweep order.
+ *
+ * Nodes live in one array sized for every segment and are recycled through
+ * a free list, and where[seg] maps a segment to its node. Only insert()
+ * calls the comparator; erase, neighbour lookups, swap and sortRun go through
+ * where[] and the thread links, so an inconsistent comparator can misplace a
+ * segment but never lose it. Neighbours are O(1), swapping two entries is
+ * O(1) (the nodes exchange their payloads), insert and erase are expected
+ * O(log n).
+ */
+template <typename Compare>
+class StatusTree {
+  public:
+  static constexpr int NONE = -1;
+
+  StatusTree(int capacity, Compare comp) :
+    nodes(capacity), where(capacity, NONE), comp(comp) {
+    free.reserve(capacity);
+    for (int k = capacity - 1; k >= 0; --k) free.push_back(k);
+  }
+
+  bool   contains(int seg) const { return where[seg] != NONE; }
+  size_t size() const { return nodes.size() - free.size(); }
+
+  // Segment right below / above seg, NONE at either end
+  int prev(int seg) const { return segOf(nodes[where[seg]].prev); }
+  int next(int seg) const { return segOf(nodes[where[seg]].next); }
+
+  // Lowest entry for which below() is false, NONE when it holds for all;
+  // below must hold for a prefix of the entries
+  template <typename Below>
+  int lowerBound(Below below) const {
+    int found = NONE;
+    for (int cur = root; cur != NONE;) {
+      if (below(nodes[cur].seg)) {
+        cur = nodes[cur].right;
+      } else {
+        found = cur;
+        cur   = nodes[cur].left;
+      }
+    }
+    return segOf(found);
+  }
+
+  // Inserts after every entry that does not compare greater than seg
+  void insert(int seg) { insertWith(seg, comp); }
+
+  // Inserts after every entry, for filling the status in order
+  void append(int seg) {
+    insertWith(seg, [](int, int) { return false; });
+  }
+
+  void erase(int seg) {
+    int x = where[seg];
+
+    // Rotate down until x is a leaf, rotations keep the in-order threads
+    while (nodes[x].left != NONE || nodes[x].right != NONE) {
+      int l = nodes[x].left, r = nodes[x].right;
+      rotateUp((r == NONE || (l != NONE && nodes[l].priority > nodes[r].priority)) ? l : r);
+    }
+
+    int parent = nodes[x].parent;
+    if (parent == NONE) root = NONE;
+    else if (nodes[parent].left == x) nodes[parent].left = NONE;
+    else nodes[parent].right = NONE;
+
+    link(nodes[x].prev, nodes[x].next);
+    where[seg] = NONE;
+    free.push_back(x);
+  }
+
+  // Exchanges the positions of a and b, meant for neighbours that cross
+  void swap(int a, int b) {
+    std::swap(where[a], where[b]);
+    nodes[where[a]].seg = a;
+    nodes[where[b]].seg = b;
+  }
+
+  // Sorts the run of entries between a and b (inclusive, either may be the
+  // lower one) by less, meant for segments meeting in one point. The nodes
+  // keep their positions and exchange payloads; run receives the new order
+  template <typename Less>
+  void sortRun(int a, int b, Less less, std::vector<int>& run) {
+    int up = where[a], down = where[a], lower = a;
+    while (true) {
+      if (up != NONE && (up = nodes[up].next) != NONE && nodes[up].seg == b) break;
+      if (down != NONE && (down = nodes[down].prev) != NONE && nodes[down].seg == b) {
+        lower = b;
+        b     = a;
+        break;
+      }
+    }
+
+    run.clear();
+    int start = where[lower];
+    for (int x = start;; x = nodes[x].next) {
+      run.push_back(nodes[x].seg);
+      if (nodes[x].seg == b) break;
+    }
+    std::sort(run.begin(), run.end(), less);
+
+    int x = start;
+    for (int seg : run) {
+      nodes[x].seg = seg;
+      where[seg]   = x;
+      x            = nodes[x].next;
+    }
+  }
+
+  private:
+  struct Node {
+    int      seg = NONE;
+    int      left = NONE, right = NONE, parent = NONE;
+    int      prev = NONE, next = NONE;
+    uint32_t priority = 0;
+  };
+
+  std::vector<Node> nodes;
+  std::vector<int>  where;
+  std::vector<int>  free;
+  Compare           comp;
+  int               root     = NONE;
+  uint32_t          inserted = 0;
+
+  template <typename Less>
+  void insertWith(int seg, Less less) {
+    int x = free.back();
+    free.pop_back();
+    nodes[x]          = Node{};
+    nodes[x].seg      = seg;
+    nodes[x].priority = hash(seg) ^ hash(++inserted);
+    where[seg]        = x;
+
+    int  parent = NONE;
+    int  cur    = root;
+    bool left   = false;
+    while (cur != NONE) {
+      parent = cur;
+      left   = less(seg, nodes[cur].seg);
+      cur    = left ? nodes[cur].left : nodes[cur].right;
+    }
+
+    nodes[x].parent = parent;
+    if (parent == NONE) {
+      root = x;
+    } else if (left) {
+      nodes[parent].left = x;
+      link(nodes[parent].prev, x);
+      link(x, parent);
+    } else {
+      nodes[parent].right = x;
+      link(x, nodes[parent].next);
+      link(parent, x);
+    }
+
+    while (nodes[x].parent != NONE && nodes[nodes[x].parent].priority < nodes[x].priority)
+      rotateUp(x);
+  }
+
+  int segOf(int x) const { return x == NONE ? NONE : nodes[x].seg; }
+
+  void link(int a, int b) {
+    if (a != NONE) nodes[a].next = b;
+    if (b != NONE) nodes[b].prev = a;
+  }
+
+  static uint32_t hash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+  }
+
+  // Rotates x above its parent
+  void rotateUp(int x) {
+    int p = nodes[x].parent;
+    int g = nodes[p].parent;
+
+    if (nodes[p].left == x) {
+      nodes[p].left = nodes[x].right;
+      if (nodes[x].right != NONE) nodes[nodes[x].right].parent = p;
+      nodes[x].right = p;
+    } else {
+      nodes[p].right = nodes[x].left;
+      if (nodes[x].left != NONE) nodes[nodes[x].left].parent = p;
+      nodes[x].left = p;
+    }
+    nodes[p].parent = x;
+    nodes[x].parent = g;
+
+    if (g == NONE) root = x;
+    else if (nodes[g].left == p) nodes[g].left = x;
+    else nodes[g].right = x;
+  }
+};
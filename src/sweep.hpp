@@ -5,6 +5,10 @@
 #include <algorithm>
 #include <set>
 #include <optional>
+#include <cstdint>
+#include <type_traits>
+#include "predicates.hpp"
+#include "sweepStats.hpp"
 /*
 
 inline constexpr float EPS = 1e-6f;
@@ -82,52 +86,75 @@ struct Segment {
   }
 };
 */
-inline constexpr float EPS = 1e-6f;
 
-inline bool fequal(float a, float b) {
-  return std::fabs(a - b) < EPS;
+/**
+ * Coordinate type of every geometric type and engine below: float for
+ * throughput, double for accuracy, or int32_t / int64_t for coordinates
+ * snapped to an integer grid. Tolerances are chosen at compile time; the
+ * integer instantiations compare exactly and have none. The non template
+ * names (Point, Segment, Sweepinfo, ...) are the float instantiations.
+ */
+template <typename T>
+inline constexpr T tolerance = T(0);
+template <>
+inline constexpr float tolerance<float> = 1e-6f;
+template <>
+inline constexpr double tolerance<double> = 1e-12;
+
+inline constexpr float EPS = tolerance<float>;
+
+template <typename T>
+inline bool fequal(T a, T b) {
+  if constexpr (std::is_integral_v<T>) return a == b;
+  else return std::fabs(a - b) < tolerance<T>;
 }
 
-inline bool lessThan(float a, float b) {
-  return a < b - EPS;
+template <typename T>
+inline bool lessThan(T a, T b) {
+  return a < b - tolerance<T>;
 }
 
-inline bool greaterThan(float a, float b) {
-  return a - b > EPS;
+template <typename T>
+inline bool greaterThan(T a, T b) {
+  return a - b > tolerance<T>;
 }
 
-inline bool lessThanOrEqual(float a, float b) {
+template <typename T>
+inline bool lessThanOrEqual(T a, T b) {
   return lessThan(a, b) || fequal(a, b);
 }
 
-inline bool greaterThanOrEqual(float a, float b) {
+template <typename T>
+inline bool greaterThanOrEqual(T a, T b) {
   return greaterThan(a, b) || fequal(a, b);
 }
 
-struct Point {
-  float x, y;
+template <typename T>
+struct BasicPoint {
+  T x, y;
 
-  inline bool operator==(const Point& other) const {
+  inline bool operator==(const BasicPoint& other) const {
     return fequal(x, other.x) && fequal(y, other.y);
   }
 
-  inline bool operator!=(const Point& other) const {
+  inline bool operator!=(const BasicPoint& other) const {
     return !(*this == other);
   }
 
-  inline bool operator<(const Point& other) const {
+  inline bool operator<(const BasicPoint& other) const {
     if (!fequal(x, other.x)) return lessThan(x, other.x);
     return lessThan(y, other.y);
   }
 };
 
-struct Segment {
-  Point a, b;
-  int   id;
+template <typename T>
+struct BasicSegment {
+  BasicPoint<T> a, b;
+  int           id;
 
   // Unified constructor: order points from left to right (increasing x),
   // breaking ties by y ascending.
-  Segment(Point p1, Point p2, int segment_id = -1) :
+  BasicSegment(BasicPoint<T> p1, BasicPoint<T> p2, int segment_id = -1) :
     id(segment_id) {
     if (lessThan(p2.x, p1.x) || (fequal(p1.x, p2.x) && lessThan(p2.y, p1.y))) {
       a = p2;
@@ -139,80 +166,316 @@ struct Segment {
   }
 
   // Default constructor for convenience
-  Segment() :
-    a(Point{0, 0}), b(Point{0, 0}), id(-1) {}
+  BasicSegment() :
+    a(BasicPoint<T>{0, 0}), b(BasicPoint<T>{0, 0}), id(-1) {}
 
-  inline bool operator==(const Segment& other) const {
+  inline bool operator==(const BasicSegment& other) const {
     return a == other.a && b == other.b;
   }
 
-  inline bool operator!=(const Segment& other) const {
+  inline bool operator!=(const BasicSegment& other) const {
     return !(*this == other);
   }
 
   // Segment comparison by endpoints with epsilon-aware ordering.
-  inline bool operator<(const Segment& other) const {
+  inline bool operator<(const BasicSegment& other) const {
     if (a < other.a) return true;
     if (other.a < a) return false;
     return b < other.b;
   }
 };
 
-struct Sweepinfo {
-  std::vector<Segment> segments;
+/**
+ * Structure of arrays copy of a segment list. Endpoint columns are dense
+ * for the batched kernel and the status comparators, which query them
+ * through the exact predicates below.
+ */
+template <typename T>
+struct BasicSegmentSoA {
+  std::vector<T> ax, ay, bx, by;
+
+  size_t size() const { return ax.size(); }
+
+  void assign(const std::vector<BasicSegment<T>>& segments) {
+    clear();
+    for (const BasicSegment<T>& s : segments) push(s);
+  }
+
+  // Stored endpoints of k run right to left (or downwards when vertical)
+  inline bool reversed(int k) const {
+    return bx[k] < ax[k] || (bx[k] == ax[k] && by[k] < ay[k]);
+  }
+
+  // Exact side of (x, y) against segment k taken left to right: > 0 above
+  // its line, < 0 below, 0 on it
+  inline int sideOf(int k, T x, T y) const {
+    return reversed(k) ? orientSign(bx[k], by[k], ax[k], ay[k], x, y)
+                       : orientSign(ax[k], ay[k], bx[k], by[k], x, y);
+  }
+
+  // Exact slope order of k and l, < 0 when k is less steep; vertical
+  // segments are the steepest
+  inline int slopeOrder(int k, int l) const {
+    int cross = crossSignOf(ax[k], ay[k], bx[k], by[k], ax[l], ay[l], bx[l], by[l]);
+    return reversed(k) == reversed(l) ? -cross : cross;
+  }
+
+  // Exact side of the abscissa where the lines of k and l meet against x,
+  // > 0 right of it; the lines must not be parallel
+  int crossingSide(int k, int l, T x) const {
+    SplitCoord lines[8];
+    splitLines(k, l, lines);
+    return crossingXSign(lines, splitCoord(x));
+  }
+
+  // Exact order of the abscissas where k, l and m, n meet
+  int crossingOrder(int k, int l, int m, int n) const {
+    SplitCoord first[8], second[8];
+    splitLines(k, l, first);
+    splitLines(m, n, second);
+    return crossingXOrder(first, second);
+  }
+
+  void splitLines(int k, int l, SplitCoord* out) const {
+    const T coords[8] = {ax[k], ay[k], bx[k], by[k], ax[l], ay[l], bx[l], by[l]};
+    for (int c = 0; c < 8; ++c) out[c] = splitCoord(coords[c]);
+  }
+
+  // Copies segments[ids[0..count)] so that lane k holds ids[k]
+  void gather(const std::vector<BasicSegment<T>>& segments, const int* ids, int count) {
+    clear();
+    for (int k = 0; k < count; ++k) push(segments[ids[k]]);
+  }
+
+  void push(const BasicSegment<T>& s) {
+    ax.push_back(s.a.x);
+    ay.push_back(s.a.y);
+    bx.push_back(s.b.x);
+    by.push_back(s.b.y);
+  }
+
+  void clear() {
+    ax.clear();
+    ay.clear();
+    bx.clear();
+    by.clear();
+  }
+};
+
+// What the engines materialize in SweepResult
+enum class ResultMode {
+  Full,           // points, split segments, the intersection map and compact
+  PairsOnly,      // intersection map only
+  CountOnly,      // intersectionCount only
+  AnyIntersection, // stop at the first hit, intersectionCount is 0 or 1
+  Compact          // flat records and CSR adjacency in compact, no trees
 };
 
-bool segmentsIntersect(const Segment& s1, const Segment& s2, Point& out);
+// One hit as streamed to an IntersectionSink, segA < segB
+template <typename T>
+struct BasicIntersectionRecord {
+  int           segA, segB;
+  BasicPoint<T> p;
+};
 
-struct SweepResult {
-  // Contains all points of intrsection
-  std::set<Point> intersectionPOints;
+/**
+ * Result of ResultMode::Compact: every hit once in a flat record array and
+ * the intersection graph in CSR form (offsets plus neighbour array), in
+ * place of one tree node per neighbour in intersectionMaps. build() runs
+ * after the engine; it orders the records by (segA, segB) with two stable
+ * counting sorts and fills the adjacency in one more pass, so neighbours
+ * come out increasing. Accessors hand out pointers into the arrays.
+ */
+template <typename T>
+struct BasicCompactResult {
+  std::vector<BasicIntersectionRecord<T>> records;
+
+  // Neighbours of segment i are neighbors[offsets[i], offsets[i + 1]);
+  // edges[k] is the index in records of the hit behind neighbors[k]
+  std::vector<size_t> offsets;
+  std::vector<int>    neighbors;
+  std::vector<size_t> edges;
+
+  size_t     segmentCount() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+  size_t     degree(int i) const { return offsets[i + 1] - offsets[i]; }
+  const int* begin(int i) const { return neighbors.data() + offsets[i]; }
+  const int* end(int i) const { return neighbors.data() + offsets[i + 1]; }
+
+  const BasicIntersectionRecord<T>& record(int i, size_t k) const { return records[edges[offsets[i] + k]]; }
+
+  // Symmetric graphs list a hit under both segments, bichromatic ones only
+  // under segA
+  void build(size_t segmentCount, bool symmetric = true) {
+    size_t keys = segmentCount;
+    for (const auto& r : records) keys = std::max<size_t>(keys, std::max(r.segA, r.segB) + 1);
+
+    std::vector<BasicIntersectionRecord<T>> sorted(records.size());
+    std::vector<size_t>                     count(keys + 1);
+    auto                                    countingSort = [&](auto key) {
+      std::fill(count.begin(), count.end(), 0);
+      for (const auto& r : records) count[key(r) + 1]++;
+      for (size_t k = 0; k < keys; ++k) count[k + 1] += count[k];
+      for (const auto& r : records) sorted[count[key(r)]++] = r;
+      records.swap(sorted);
+    };
+    countingSort([](const BasicIntersectionRecord<T>& r) { return r.segB; });
+    countingSort([](const BasicIntersectionRecord<T>& r) { return r.segA; });
+
+    // A segment meets its smaller neighbours as segB of earlier records,
+    // then its larger ones as segA, so each list fills in increasing order
+    offsets.assign(segmentCount + 1, 0);
+    for (const auto& r : records) {
+      offsets[r.segA + 1]++;
+      if (symmetric) offsets[r.segB + 1]++;
+    }
+    for (size_t i = 0; i < segmentCount; ++i) offsets[i + 1] += offsets[i];
+
+    std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+    neighbors.resize(offsets.back());
+    edges.resize(offsets.back());
+    for (size_t k = 0; k < records.size(); ++k) {
+      const auto& r  = records[k];
+      size_t      at = fill[r.segA]++;
+      neighbors[at]  = r.segB;
+      edges[at]      = k;
+      if (!symmetric) continue;
+      at            = fill[r.segB]++;
+      neighbors[at] = r.segA;
+      edges[at]     = k;
+    }
+  }
+};
+
+/**
+ * Receives every hit as soon as an engine reaches it, see sweepSink.hpp for
+ * the callback, ring buffer and file implementations. Pair a sink with
+ * ResultMode::CountOnly to keep the engine memory independent of k.
+ */
+template <typename T>
+class BasicIntersectionSink {
+  public:
+  virtual ~BasicIntersectionSink() = default;
+
+  // Returning false stops the engine
+  virtual bool emit(const BasicIntersectionRecord<T>& record) = 0;
+};
 
-  // Contains all segments resulting of intersection, that is, if segment A-B
-  // intersects with C-D it returns this vector includes the resulting for
-  // different segments containing the intersection point
+template <typename T>
+struct BasicSweepinfo {
+  std::vector<BasicSegment<T>> segments;
 
-  std::set<Segment> intersectionSegments;
+  ResultMode                mode = ResultMode::Full;
+  BasicIntersectionSink<T>* sink = nullptr;
+
+  // Optional columnar copy of segments; engines build their own per call
+  // unless the caller prebuilt it with buildColumns()
+  std::optional<BasicSegmentSoA<T>> columns;
+
+  void buildColumns() {
+    columns.emplace();
+    columns->assign(segments);
+  }
+};
+
+// Columns of info, either the prebuilt ones or built into storage
+template <typename T>
+inline const BasicSegmentSoA<T>& columnsOf(const BasicSweepinfo<T>& info, BasicSegmentSoA<T>& storage) {
+  if (info.columns) return *info.columns;
+  storage.assign(info.segments);
+  return storage;
+}
+
+// Intersection points of integer segments are rounded to the grid
+template <typename T>
+bool segmentsIntersect(const BasicSegment<T>& s1, const BasicSegment<T>& s2, BasicPoint<T>& out);
+
+template <typename T>
+struct BasicSweepResult {
+  // Contains all points of intrsection
+  std::set<BasicPoint<T>> intersectionPOints;
+
+  // Arrangement edges of the intersecting segments: each one cut at every
+  // crossing on it, pieces in order from a to b with the index of their
+  // segment as id (see sweepSplit.hpp)
+  std::vector<BasicSegment<T>> intersectionSegments;
 
   // Contains a map that maps segment_i with all its intersecting segment
   // indices
   std::map<int, std::set<int>> intersectionMaps;
 
-  inline bool operator==(const SweepResult& other) {
-    return intersectionPOints == other.intersectionPOints;
-  }
+  // Flat records and CSR adjacency, filled in ResultMode::Compact and Full
+  BasicCompactResult<T> compact;
+
+  // Number of intersecting pairs, filled in every ResultMode
+  size_t intersectionCount = 0;
+
+  // Units of work performed: popped events for the sweep engines, candidate
+  // pair tests for the naive and interval engines
+  size_t eventsProcessed = 0;
+
+  // Detailed counters, only filled in SWEEP_STATS builds
+  SweepStats stats;
+
+  // Results are compared through canonicalOf() (sweepCanonical.hpp)
 };
 
-SweepResult findIntersectionsInterval(const Sweepinfo& info);
-SweepResult findIntersections(const Sweepinfo& info);
-SweepResult findIntersections2(const Sweepinfo& info);
-SweepResult findIntersectionsLibrary(const Sweepinfo& info);
-SweepResult findIntersectionsNaive(const Sweepinfo& info);
-
-inline std::optional<Point> intersect(const Segment& a, const Segment& b) {
-  Point r     = {a.b.x - a.a.x, a.b.y - a.a.y};
-  Point s     = {b.b.x - b.a.x, b.b.y - b.a.y};
-  float denom = r.x * s.y - r.y * s.x;
-  if (fequal(denom, 0)) return std::nullopt;
-
-  Point diff = {b.a.x - a.a.x, b.a.y - a.a.y};
-  float t    = (diff.x * s.y - diff.y * s.x) / denom;
-  float u    = (diff.x * r.y - diff.y * r.x) / denom;
-  if (t < -EPS || t > 1 + EPS || u < -EPS || u > 1 + EPS)
-    return std::nullopt;
-
-  return Point{a.a.x + t * r.x, a.a.y + t * r.y};
+using Point              = BasicPoint<float>;
+using Segment            = BasicSegment<float>;
+using SegmentSoA         = BasicSegmentSoA<float>;
+using IntersectionRecord = BasicIntersectionRecord<float>;
+using IntersectionSink   = BasicIntersectionSink<float>;
+using Sweepinfo          = BasicSweepinfo<float>;
+using SweepResult        = BasicSweepResult<float>;
+using CompactResult      = BasicCompactResult<float>;
+
+// Every engine is instantiated for float, double, int32_t and int64_t
+template <typename T>
+using Engine = BasicSweepResult<T> (*)(const BasicSweepinfo<T>& info);
+
+template <typename T>
+BasicSweepResult<T> findIntersectionsInterval(const BasicSweepinfo<T>& info);
+template <typename T>
+BasicSweepResult<T> findIntersections(const BasicSweepinfo<T>& info);
+template <typename T>
+BasicSweepResult<T> findIntersections2(const BasicSweepinfo<T>& info);
+template <typename T>
+BasicSweepResult<T> findIntersectionsLibrary(const BasicSweepinfo<T>& info);
+template <typename T>
+BasicSweepResult<T> findIntersectionsNaive(const BasicSweepinfo<T>& info);
+template <typename T>
+BasicSweepResult<T> findIntersectionsParallel(const BasicSweepinfo<T>& info);
+template <typename T>
+BasicSweepResult<T> findIntersectionsGrid(const BasicSweepinfo<T>& info);
+template <typename T>
+BasicSweepResult<T> findIntersectionsTiled(const BasicSweepinfo<T>& info);
+
+// Explicit instantiations of an engine for every coordinate type, used at
+// the end of the engine's translation unit
+#define INSTANTIATE_ENGINE(engine)                                                 \
+  template BasicSweepResult<float>   engine(const BasicSweepinfo<float>& info);   \
+  template BasicSweepResult<double>  engine(const BasicSweepinfo<double>& info);  \
+  template BasicSweepResult<int32_t> engine(const BasicSweepinfo<int32_t>& info); \
+  template BasicSweepResult<int64_t> engine(const BasicSweepinfo<int64_t>& info);
+
+template <typename T>
+inline std::optional<BasicPoint<T>> intersect(const BasicSegment<T>& a, const BasicSegment<T>& b) {
+  BasicPoint<T> p;
+  if (!segmentsIntersect(a, b, p)) return std::nullopt;
+  return p;
 }
 
-inline int orientation(Point p, Point q, Point r) {
-  float val = (q.y - p.y) * (r.x - q.x) - (q.x - p.x) * (r.y - q.y);
-  if (fequal(val, 0.0f)) return 0;
-  return (val > 0) ? 1 : 2;
+// 0 collinear, 1 clockwise, 2 counterclockwise, decided exactly
+template <typename T>
+inline int orientation(BasicPoint<T> p, BasicPoint<T> q, BasicPoint<T> r) {
+  int val = orientSign(p.x, p.y, q.x, q.y, r.x, r.y);
+  if (val == 0) return 0;
+  return (val < 0) ? 1 : 2;
 }
 
 // Checks if point q lies on segment pr
-inline bool onSegment(Point p, Point q, Point r) {
-  return fequal(orientation(p, q, r), 0) &&
+template <typename T>
+inline bool onSegment(BasicPoint<T> p, BasicPoint<T> q, BasicPoint<T> r) {
+  return orientation(p, q, r) == 0 &&
     lessThanOrEqual(std::min(p.x, r.x), q.x) &&
     greaterThanOrEqual(std::max(p.x, r.x), q.x) &&
     lessThanOrEqual(std::min(p.y, r.y), q.y) &&
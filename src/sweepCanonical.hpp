@@ -0,0 +1,126 @@
+#pragma once
+#include "sweep.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+/**
+ * Canonical form of a SweepResult for comparing engines.
+ *
+ * The result containers are trees ordered by epsilon comparators, which are
+ * not transitive, so comparing them elementwise can fail on equal results
+ * and cannot tell which hits differ. Here the pairs become one sorted flat
+ * array of (min id, max id), and the point of every hit record is snapped
+ * to an integer cell of a fixed step, sorted and deduplicated, so no point
+ * goes through the epsilon set first. Two canonical results are equal
+ * exactly when their arrays are, which is checked in linear time and in
+ * parallel, and diff() walks both arrays once to list every pair or point
+ * one side has and the other has not.
+ */
+
+using CanonicalPair = std::pair<int, int>;
+using CanonicalCell = std::pair<int64_t, int64_t>;
+
+// Snap step of the points: the comparison tolerance for floating point
+// coordinates, the unit for integer ones
+template <typename T>
+inline constexpr double snapStep = std::is_integral_v<T> ? 1.0 : double(tolerance<T>);
+
+template <typename T>
+struct CanonicalResult {
+  std::vector<CanonicalPair> pairs;
+  std::vector<CanonicalCell> points;
+  double                     step = snapStep<T>;
+
+  BasicPoint<T> pointOf(const CanonicalCell& cell) const { return {T(cell.first * step), T(cell.second * step)}; }
+};
+
+template <typename T>
+int64_t snapped(T v, double step) {
+  if constexpr (std::is_integral_v<T>)
+    if (step == 1.0) return v;
+  return std::llround(double(v) / step);
+}
+
+// Differences of a result against the expected one
+template <typename T>
+struct CanonicalDiff {
+  std::vector<CanonicalPair> missingPairs; // expected, not found
+  std::vector<CanonicalPair> extraPairs;   // found, not expected
+  std::vector<CanonicalCell> missingPoints;
+  std::vector<CanonicalCell> extraPoints;
+
+  bool empty() const {
+    return missingPairs.empty() && extraPairs.empty() && missingPoints.empty() && extraPoints.empty();
+  }
+};
+
+template <typename Item>
+void sortUnique(std::vector<Item>& items) {
+  if (!std::is_sorted(items.begin(), items.end())) std::sort(items.begin(), items.end());
+  items.erase(std::unique(items.begin(), items.end()), items.end());
+}
+
+template <typename T>
+CanonicalResult<T> canonicalOf(const BasicSweepResult<T>& result, double step = snapStep<T>) {
+  CanonicalResult<T> canonical;
+  canonical.step = step;
+
+  // Symmetric maps list each pair from both ends, red-blue maps once
+  for (const auto& [i, hits] : result.intersectionMaps)
+    for (int j : hits) canonical.pairs.push_back({std::min(i, j), std::max(i, j)});
+  sortUnique(canonical.pairs);
+
+  // Points come from the records, kept in Full and Compact mode
+  canonical.points.reserve(result.compact.records.size());
+  for (const BasicIntersectionRecord<T>& r : result.compact.records)
+    canonical.points.push_back({snapped(r.p.x, step), snapped(r.p.y, step)});
+  sortUnique(canonical.points);
+  return canonical;
+}
+
+// Elementwise equality of two flat arrays, split in chunks across threads
+template <typename Item>
+bool sameItems(const std::vector<Item>& a, const std::vector<Item>& b) {
+  constexpr long CHUNK = 1 << 16;
+  if (a.size() != b.size()) return false;
+
+  long chunks = (long(a.size()) + CHUNK - 1) / CHUNK;
+  bool same   = true;
+#pragma omp parallel for reduction(&& : same) if (chunks > 1)
+  for (long c = 0; c < chunks; ++c) {
+    auto first = a.begin() + c * CHUNK;
+    auto last  = a.begin() + std::min<long>(a.size(), (c + 1) * CHUNK);
+    same       = same && std::equal(first, last, b.begin() + c * CHUNK);
+  }
+  return same;
+}
+
+template <typename T>
+bool operator==(const CanonicalResult<T>& a, const CanonicalResult<T>& b) {
+  return a.step == b.step && sameItems(a.pairs, b.pairs) && sameItems(a.points, b.points);
+}
+
+template <typename T>
+bool operator!=(const CanonicalResult<T>& a, const CanonicalResult<T>& b) {
+  return !(a == b);
+}
+
+// Merges two sorted arrays, keeping what only one of them holds
+template <typename Item>
+void differences(const std::vector<Item>& expected, const std::vector<Item>& found,
+                 std::vector<Item>& missing, std::vector<Item>& extra) {
+  std::set_difference(expected.begin(), expected.end(), found.begin(), found.end(), std::back_inserter(missing));
+  std::set_difference(found.begin(), found.end(), expected.begin(), expected.end(), std::back_inserter(extra));
+}
+
+template <typename T>
+CanonicalDiff<T> diff(const CanonicalResult<T>& expected, const CanonicalResult<T>& found) {
+  CanonicalDiff<T> d;
+  differences(expected.pairs, found.pairs, d.missingPairs, d.extraPairs);
+  differences(expected.points, found.points, d.missingPoints, d.extraPoints);
+  return d;
+}
@@ -0,0 +1,298 @@
+#pragma once
+#include "sweep.hpp"
+#include "sweepKernel.hpp"
+#include "pairSet.hpp"
+#include "sweepReport.hpp"
+#include "statusTree.hpp"
+#include "sweepEndpoints.hpp"
+#include <optional>
+#include <queue>
+#include <vector>
+
+/**
+ * Bentley-Ottmann sweep shared by findIntersections and findIntersections2.
+ *
+ * Endpoints come presorted from endpointOrder() and are merged with a heap
+ * holding only the crossings. Events are ordered exactly: a crossing carries
+ * an interval around its abscissa and only overlapping intervals are decided
+ * with the exact predicates. At one x the crossings go first, then the
+ * insertions, the vertical segments and the removals, so the status is
+ * always ordered just right of the sweep line, by the exact side of the
+ * sweep point and then by the exact slope order. The two engines only differ
+ * in TieById, which breaks slope ties between collinear segments by id so
+ * that their order in the status is deterministic.
+ *
+ * Vertical segments never enter the status: each one walks the entries
+ * between its ends at its x, after the insertions and before the removals
+ * there. A segment starting on others is tested against every entry
+ * through its left end, which are next to it in the status.
+ */
+
+template <typename T>
+struct SweepCrossing {
+  WideCoord<T>  lo, hi; // bounds of the crossing abscissa
+  BasicPoint<T> p;
+  int           segA, segB;
+};
+
+// Heap order of the crossings, exact: true when a comes after b
+template <typename T>
+struct CrossingLater {
+  const BasicSegmentSoA<T>* columns;
+
+  bool operator()(const SweepCrossing<T>& a, const SweepCrossing<T>& b) const {
+    if (a.hi < b.lo) return false;
+    if (b.hi < a.lo) return true;
+    int order = columns->crossingOrder(a.segA, a.segB, b.segA, b.segB);
+    if (order != 0) return order > 0;
+    return a.segA != b.segA ? a.segA > b.segA : a.segB > b.segB;
+  }
+};
+
+template <typename T, bool TieById>
+struct SweepOrder {
+  const BasicPoint<T>&      sweepPoint;
+  const BasicSegmentSoA<T>& columns;
+  SweepStats&               stats;
+
+  SweepOrder(const BasicPoint<T>& sweepPoint, const BasicSegmentSoA<T>& columns, SweepStats& stats) :
+    sweepPoint(sweepPoint), columns(columns), stats(stats) {}
+
+  // Slope order, optionally made total by the ids
+  bool bySlope(int i, int j) const {
+    SWEEP_STAT(stats.comparatorCalls++);
+    int order = columns.slopeOrder(i, j);
+    if (TieById && order == 0) return i < j;
+    return order < 0;
+  }
+
+  // Only called by insert(): i is the segment being placed and passes
+  // through the sweep point, so its side of j decides exactly
+  bool operator()(int i, int j) const {
+    SWEEP_STAT(stats.comparatorCalls++);
+    int side = columns.sideOf(j, sweepPoint.x, sweepPoint.y);
+    if (side != 0) return side < 0;
+    // Meeting on the sweep line: the lower one right after it goes first
+    return bySlope(i, j);
+  }
+};
+
+/**
+ * Sweeps segments (with columns, their SoA copy) and hands every hit to
+ * reporter, anything with add(i, j, p), earlyExit() and stopped() like
+ * HitReporter. An optional window [from, to) restricts the sweep to a slab:
+ * segments starting left of from enter the status at once in their order
+ * there, and only crossings whose exact abscissa lies in the window are
+ * reported, so adjacent slabs never report the same pair twice.
+ */
+template <typename T, bool TieById, typename Reporter>
+void sweepSegments(const std::vector<BasicSegment<T>>& segments, const BasicSegmentSoA<T>& columns,
+                   Reporter& reporter, SweepStats& stats, size_t& eventsProcessed,
+                   std::optional<T> from = std::nullopt, std::optional<T> to = std::nullopt) {
+  using Crossing = SweepCrossing<T>;
+  using Order    = SweepOrder<T, TieById>;
+  using Status   = StatusTree<Order>;
+  using W        = WideCoord<T>;
+
+  // Endpoints are sorted once and merged with a heap holding only the
+  // crossings, which has room reserved for about as many as segments
+  std::vector<uint32_t> endpoints = endpointOrder(columns);
+  std::vector<Crossing> heap;
+  heap.reserve(segments.size());
+  std::priority_queue<Crossing, std::vector<Crossing>, CrossingLater<T>> eventQueue(CrossingLater<T>{&columns},
+                                                                                     std::move(heap));
+
+  // Left end for insertions and vertical segments (their lower end), right
+  // end for removals
+  auto endpointOf = [&](uint32_t code) {
+    int i = code >> 1;
+    return (code & 1) == columns.reversed(i) ? BasicPoint<T>{columns.ax[i], columns.ay[i]}
+                                             : BasicPoint<T>{columns.bx[i], columns.by[i]};
+  };
+  auto leftX = [&](int i) { return std::min(columns.ax[i], columns.bx[i]); };
+
+  BasicPoint<T> sweepPoint = {0, 0};
+  Order         order(sweepPoint, columns, stats);
+  Status        activeSet(segments.size(), order);
+  PairSet       scheduled(2 * segments.size());
+
+  // The crossing abscissa is bracketed in WideCoord and clamped into the
+  // common x-extent of the pair, where it lies exactly
+  auto crossingOf = [&](int i, int j, BasicPoint<T> p) {
+    Crossing c{0, 0, p, i, j};
+    crossingBounds(columns.ax[i], columns.ay[i], columns.bx[i], columns.by[i], columns.ax[j], columns.ay[j], columns.bx[j], columns.by[j], c.lo, c.hi);
+    c.lo = std::max<W>(c.lo, std::max(leftX(i), leftX(j)));
+    c.hi = std::min<W>(c.hi, std::min(std::max(columns.ax[i], columns.bx[i]), std::max(columns.ax[j], columns.bx[j])));
+    return c;
+  };
+
+  // Sign of the crossing abscissa minus x, exact
+  auto crossingSide = [&](const Crossing& c, T x) {
+    if (c.hi < W(x)) return -1;
+    if (c.lo > W(x)) return 1;
+    return columns.crossingSide(c.segA, c.segB, x);
+  };
+
+  // A hit left of the window belongs to the slab before, only segments that
+  // both start left of it can have one
+  auto inWindow = [&](int i, int j, BasicPoint<T> p) {
+    return !from || leftX(i) >= *from || leftX(j) >= *from || crossingSide(crossingOf(i, j, p), *from) >= 0;
+  };
+
+  // segmentsIntersect() does not depend on the sweep position, so a pair only
+  // needs to be tested once. lower sits below upper; when it is already the
+  // less steep one the pair meets at or behind the sweep line and is
+  // reported without a swap. In AnyIntersection mode the first neighbour
+  // hit ends the sweep (Shamos-Hoey), and one event may test several pairs,
+  // so nothing is tested once the reporter stopped
+  auto tryAddIntersection = [&](int lower, int upper) {
+    if (lower == Status::NONE || upper == Status::NONE || reporter.stopped()) return;
+    int i = std::min(lower, upper), j = std::max(lower, upper);
+    if (!scheduled.insert(i, j)) {
+      SWEEP_STAT(stats.duplicateSchedules++);
+      return;
+    }
+    SWEEP_STAT(stats.pairTests++);
+    BasicPoint<T> pt;
+    if (segmentsIntersect(segments[i], segments[j], pt)) {
+      if (reporter.earlyExit()) reporter.add(i, j, pt);
+      else if (columns.slopeOrder(lower, upper) >= 0) eventQueue.push(crossingOf(i, j, pt));
+      else if (inWindow(i, j, pt)) reporter.add(i, j, pt);
+    }
+  };
+
+  std::vector<int> run;
+  auto             bySlope = [&](int i, int j) { return order.bySlope(i, j); };
+
+  // Segments reaching into the window from the left, in their order right
+  // of from: by height at from, decided through the side of their crossing
+  // (or, for parallel ones, the side of a point), then by slope. Entries
+  // at the same height meet there and are all tested
+  if (from) {
+    std::vector<int> spanning;
+    for (int i = 0; i < (int)segments.size(); ++i)
+      if (columns.ax[i] != columns.bx[i] && leftX(i) < *from && std::max(columns.ax[i], columns.bx[i]) >= *from)
+        spanning.push_back(i);
+
+    auto heightAt = [&](int i, int j) {
+      int slope = columns.slopeOrder(i, j);
+      if (slope == 0) return columns.sideOf(j, columns.ax[i], columns.ay[i]);
+      Crossing c{0, 0, {}, i, j};
+      crossingBounds(columns.ax[i], columns.ay[i], columns.bx[i], columns.by[i], columns.ax[j], columns.ay[j], columns.bx[j], columns.by[j], c.lo, c.hi);
+      // The steeper one is lower left of the crossing, higher right of it
+      return -crossingSide(c, *from) * slope;
+    };
+    std::sort(spanning.begin(), spanning.end(), [&](int i, int j) {
+      int height = heightAt(i, j);
+      return height != 0 ? height < 0 : order.bySlope(i, j);
+    });
+
+    for (size_t first = 0, last; first < spanning.size(); first = last) {
+      for (last = first + 1; last < spanning.size() && heightAt(spanning[first], spanning[last]) == 0; ++last) {}
+      for (size_t l = first; l < last; ++l)
+        for (size_t u = l + 1; u < last; ++u) tryAddIntersection(spanning[l], spanning[u]);
+    }
+    for (int seg : spanning) {
+      activeSet.append(seg);
+      tryAddIntersection(activeSet.prev(seg), seg);
+    }
+  }
+
+  // x of the next endpoint event, checked against the heap top
+  size_t next = 0;
+  while (next < endpoints.size() && from && endpointOf(endpoints[next]).x < *from) ++next;
+  T nextX = next < endpoints.size() ? endpointOf(endpoints[next]).x : T(0);
+  while ((next < endpoints.size() || !eventQueue.empty()) && !reporter.stopped()) {
+    SWEEP_STAT(SweepStats::raise(stats.maxQueueSize, eventQueue.size()));
+
+    if (!eventQueue.empty() && (next == endpoints.size() || crossingSide(eventQueue.top(), nextX) <= 0)) {
+      Crossing ev = eventQueue.top();
+      if (to && crossingSide(ev, *to) >= 0) break;
+      eventQueue.pop();
+      eventsProcessed++;
+      SWEEP_STAT(stats.crossingEvents++);
+      reporter.add(ev.segA, ev.segB, ev.p);
+
+      int segA = ev.segA;
+      int segB = ev.segB;
+      if (!activeSet.contains(segA) || !activeSet.contains(segB)) continue;
+
+      // Crossing neighbours trade places in O(1), unless a run sorted at the
+      // same point already did. Otherwise more segments meet in this point
+      // and lie between the two; the whole run takes its order past the
+      // crossing, which is by slope
+      if (activeSet.next(segA) == segB || activeSet.next(segB) == segA) {
+        int lower = activeSet.next(segA) == segB ? segA : segB;
+        run.assign({segA, segB});
+        if (columns.slopeOrder(lower, lower == segA ? segB : segA) > 0) activeSet.swap(segA, segB);
+      } else {
+        activeSet.sortRun(segA, segB, bySlope, run);
+
+        // The run jumped past its crossing in one step, so pairs inside it
+        // that were never neighbours are tested here
+        for (size_t l = 0; l < run.size(); ++l)
+          for (size_t u = l + 1; u < run.size(); ++u) tryAddIntersection(run[l], run[u]);
+      }
+
+      for (int seg : run) {
+        tryAddIntersection(activeSet.prev(seg), seg);
+        tryAddIntersection(seg, activeSet.next(seg));
+      }
+      continue;
+    }
+
+    if (to && nextX >= *to) break;
+    uint32_t code = endpoints[next++];
+    int      seg  = code >> 1;
+    sweepPoint    = endpointOf(code);
+    if (next < endpoints.size()) nextX = endpointOf(endpoints[next]).x;
+    eventsProcessed++;
+
+    if (columns.ax[seg] == columns.bx[seg]) {
+      // Vertical: every entry between its ends at this x is a candidate
+      SWEEP_STAT(stats.insertEvents++);
+      T   top   = std::max(columns.ay[seg], columns.by[seg]);
+      int first = activeSet.lowerBound([&](int j) { return columns.sideOf(j, sweepPoint.x, sweepPoint.y) > 0; });
+      for (int j = first; j != Status::NONE && columns.sideOf(j, sweepPoint.x, top) >= 0; j = activeSet.next(j)) {
+        SWEEP_STAT(stats.pairTests++);
+        BasicPoint<T> pt;
+        if (segmentsIntersect(segments[seg], segments[j], pt)) {
+          reporter.add(std::min(seg, j), std::max(seg, j), pt);
+          if (reporter.stopped()) break;
+        }
+      }
+    } else if ((code & 1) == 0) {
+      SWEEP_STAT(stats.insertEvents++);
+      activeSet.insert(seg);
+      SWEEP_STAT(SweepStats::raise(stats.maxStatusSize, activeSet.size()));
+
+      // Entries through the left end form a block around seg, all of them
+      // meet it there; the first entry off the point is the plain neighbour
+      for (int up = activeSet.next(seg); up != Status::NONE; up = activeSet.next(up)) {
+        tryAddIntersection(seg, up);
+        if (columns.sideOf(up, sweepPoint.x, sweepPoint.y) != 0) break;
+      }
+      for (int down = activeSet.prev(seg); down != Status::NONE; down = activeSet.prev(down)) {
+        tryAddIntersection(down, seg);
+        if (columns.sideOf(down, sweepPoint.x, sweepPoint.y) != 0) break;
+      }
+    } else {
+      SWEEP_STAT(stats.removeEvents++);
+      if (!activeSet.contains(seg)) continue;
+      tryAddIntersection(activeSet.prev(seg), activeSet.next(seg));
+      activeSet.erase(seg);
+    }
+  }
+}
+
+template <typename T, bool TieById>
+BasicSweepResult<T> sweepLine(const BasicSweepinfo<T>& info) {
+  BasicSweepResult<T>       result;
+  BasicSegmentSoA<T>        storage;
+  const BasicSegmentSoA<T>& columns = columnsOf(info, storage);
+  HitReporter               reporter(info, result);
+
+  sweepSegments<T, TieById>(info.segments, columns, reporter, result.stats, result.eventsProcessed);
+  reporter.finish();
+  return result;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include "sweep.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * Endpoint events of the sweeps, sorted once up front.
+ *
+ * Segment i contributes code 2i (insertion at its left end) and 2i + 1
+ * (removal at its right end); a vertical segment only contributes 2i and is
+ * handled in place. The codes are ordered by x and at the same x by phase:
+ * insertions, then vertical segments, then removals. x is mapped to
+ * unsigned bits that sort like the value. For 32 bit coordinates key and
+ * code are packed in one 64 bit word and sorted with three 11 bit LSD radix
+ * passes; the key only holds the removal flag, vertical segments follow the
+ * insertions at their x because they are laid out after them and the passes
+ * are stable. 64 bit coordinates do not fit and use std::sort.
+ */
+
+// Unsigned bits ordered like the coordinate, -0 folded onto +0
+template <typename T>
+auto orderedBits(T v) {
+  if constexpr (std::is_integral_v<T>) {
+    using U = std::make_unsigned_t<T>;
+    return U(v) ^ (U(1) << (8 * sizeof(T) - 1));
+  } else {
+    using U = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+    U bits;
+    v = v == 0 ? T(0) : v;
+    std::memcpy(&bits, &v, sizeof(T));
+    return bits >> (8 * sizeof(T) - 1) ? ~bits : bits | (U(1) << (8 * sizeof(T) - 1));
+  }
+}
+
+template <typename T>
+std::vector<uint32_t> endpointOrder(const BasicSegmentSoA<T>& columns) {
+  uint32_t n = columns.size();
+  auto     xOf = [&](uint32_t code) {
+    uint32_t i = code >> 1;
+    return (code & 1) == columns.reversed(i) ? columns.ax[i] : columns.bx[i];
+  };
+
+  // Non vertical codes first, then one code per vertical segment
+  std::vector<uint32_t> order;
+  order.reserve(2 * size_t(n));
+  for (uint32_t i = 0; i < n; ++i)
+    if (columns.ax[i] != columns.bx[i]) order.insert(order.end(), {2 * i, 2 * i + 1});
+  size_t verticals = order.size();
+  for (uint32_t i = 0; i < n; ++i)
+    if (columns.ax[i] == columns.bx[i]) order.push_back(2 * i);
+
+  if constexpr (sizeof(T) == 4) {
+    // key = x bits and the removal flag in the top 33 bits, code below
+    static constexpr int RADIX = 11, PASSES = 3, CODE_BITS = 31;
+    std::vector<uint64_t> entries(order.size()), swapped(order.size());
+    for (size_t k = 0; k < order.size(); ++k)
+      entries[k] = ((uint64_t(orderedBits(xOf(order[k]))) << 1 | (order[k] & 1)) << CODE_BITS) | order[k];
+
+    std::vector<size_t> count((1 << RADIX) + 1);
+    for (int pass = 0; pass < PASSES; ++pass) {
+      int shift = CODE_BITS + pass * RADIX;
+      std::fill(count.begin(), count.end(), 0);
+      for (uint64_t e : entries) count[((e >> shift) & ((1 << RADIX) - 1)) + 1]++;
+      for (int d = 0; d < (1 << RADIX); ++d) count[d + 1] += count[d];
+      for (uint64_t e : entries) swapped[count[(e >> shift) & ((1 << RADIX) - 1)]++] = e;
+      entries.swap(swapped);
+    }
+    for (size_t k = 0; k < order.size(); ++k) order[k] = uint32_t(entries[k] & ((uint64_t(1) << CODE_BITS) - 1));
+  } else {
+    // x bits, then the phase (0 insertion, 1 vertical, 2 removal) above the code
+    std::vector<std::pair<uint64_t, uint64_t>> entries(order.size());
+    for (size_t k = 0; k < order.size(); ++k) {
+      uint64_t phase = order[k] & 1 ? 2 : k >= verticals;
+      entries[k]     = {orderedBits(xOf(order[k])), phase << 32 | order[k]};
+    }
+    std::sort(entries.begin(), entries.end());
+    for (size_t k = 0; k < order.size(); ++k) order[k] = uint32_t(entries[k].second);
+  }
+  return order;
+}
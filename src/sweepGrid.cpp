@@ -0,0 +1,204 @@
+#include "sweep.hpp"
+#include "sweepKernel.hpp"
+#include "sweepReport.hpp"
+#include <atomic>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Uniform grid engine for short segment workloads.
+ *
+ * The bounding box of the input is cut into square cells about as wide as
+ * the average segment, capped at a few cells per segment. Every segment is
+ * bucketed into the cells it passes through, walked column by column
+ * (counting sort into flat CSR arrays), so a long diagonal costs its length
+ * in cells rather than its bounding box. Only pairs sharing a cell are
+ * tested. A pair is reported by the one cell holding its intersection
+ * point, clamped to the common bounding box of both segments; when
+ * rounding puts that point in a cell missing one of them, the lowest
+ * shared cell reports it instead. Cells are independent and processed in
+ * parallel.
+ */
+
+template <typename T>
+class UniformGrid {
+  public:
+  UniformGrid(const std::vector<BasicSegment<T>>& segments) {
+    int n = segments.size();
+    if (n == 0) return;
+
+    double length = 0;
+    minX = maxX = double(segments[0].a.x);
+    minY = maxY = double(segments[0].a.y);
+    for (const BasicSegment<T>& s : segments) {
+      for (const BasicPoint<T>& p : {s.a, s.b}) {
+        minX = std::min(minX, double(p.x));
+        maxX = std::max(maxX, double(p.x));
+        minY = std::min(minY, double(p.y));
+        maxY = std::max(maxY, double(p.y));
+      }
+      length += std::hypot(double(s.b.x) - double(s.a.x), double(s.b.y) - double(s.a.y));
+    }
+
+    // Average length, grown until there are at most ~4 cells per segment
+    double width  = std::max(maxX - minX, 1e-30);
+    double height = std::max(maxY - minY, 1e-30);
+    cell          = std::max(length / n, 1e-30);
+    double cells  = std::ceil(width / cell) * std::ceil(height / cell);
+    if (cells > 4.0 * n) cell *= std::sqrt(cells / (4.0 * n));
+    nx = std::max(1, int(std::ceil(width / cell)));
+    ny = std::max(1, int(std::ceil(height / cell)));
+
+    // Counting sort of (cell, segment) entries, ids ascend inside a cell
+    start.assign(size_t(nx) * ny + 1, 0);
+    for (const BasicSegment<T>& s : segments) forEachCell(s, [&](size_t c) { start[c + 1]++; });
+    for (size_t c = 0; c + 1 < start.size(); ++c) start[c + 1] += start[c];
+
+    std::vector<size_t> fill(start.begin(), start.end() - 1);
+    items.resize(start.back());
+    for (int i = 0; i < n; ++i) forEachCell(segments[i], [&](size_t c) { items[fill[c]++] = i; });
+  }
+
+  size_t cells() const { return start.empty() ? 0 : start.size() - 1; }
+
+  // Members of cell c, in increasing id order
+  const int* begin(size_t c) const { return items.data() + start[c]; }
+  int        count(size_t c) const { return int(start[c + 1] - start[c]); }
+
+  size_t cellOf(double x, double y) const {
+    return size_t(row(y)) * nx + column(x);
+  }
+
+  bool holds(size_t c, int id) const { return std::binary_search(begin(c), begin(c) + count(c), id); }
+
+  // Lowest cell holding both s and segment other
+  size_t firstShared(const BasicSegment<T>& s, int other) const {
+    size_t first = cells();
+    forEachCell(s, [&](size_t c) {
+      if (c < first && holds(c, other)) first = c;
+    });
+    return first;
+  }
+
+  private:
+  double              minX = 0, maxX = 0, minY = 0, maxY = 0, cell = 1;
+  int                 nx = 0, ny = 0;
+  std::vector<size_t> start;
+  std::vector<int>    items;
+
+  int column(double x) const { return std::clamp(int((x - minX) / cell), 0, nx - 1); }
+  int row(double y) const { return std::clamp(int((y - minY) / cell), 0, ny - 1); }
+
+  // Cells s passes through: in every column of its x-extent, the rows its
+  // y-range over that column covers. Both ranges are widened by a hair so
+  // that a point of s never maps to a cell the walk skipped
+  template <typename F>
+  void forEachCell(const BasicSegment<T>& s, F&& f) const {
+    double ax = s.a.x, ay = s.a.y, bx = s.b.x, by = s.b.y;
+    if (bx < ax) {
+      std::swap(ax, bx);
+      std::swap(ay, by);
+    }
+    double slack  = 1e-9 * cell;
+    double slope  = bx > ax ? (by - ay) / (bx - ax) : 0;
+    double bottom = std::min(ay, by), top = std::max(ay, by);
+
+    int first = column(ax), last = column(bx);
+    for (int x = first; x <= last; ++x) {
+      double from = std::max(ax, minX + x * cell - slack);
+      double to   = std::min(bx, minX + (x + 1) * cell + slack);
+      double y0   = x == first ? ay : ay + (from - ax) * slope;
+      double y1   = x == last ? by : ay + (to - ax) * slope;
+      int    low  = row(std::max(bottom, std::min(y0, y1)) - slack);
+      int    high = row(std::min(top, std::max(y0, y1)) + slack);
+      for (int y = low; y <= high; ++y) f(size_t(y) * nx + x);
+    }
+  }
+};
+
+template <typename T>
+BasicSweepResult<T> findIntersectionsGrid(const BasicSweepinfo<T>& info) {
+  const auto&    segments = info.segments;
+  UniformGrid<T> grid(segments);
+
+  int threads = 1;
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+
+  // Same bookkeeping as the slab engine, with one hit buffer per thread
+  bool                                    keepHits = keepsHits(info);
+  std::atomic<bool>                       anyFound = false;
+  std::vector<std::vector<PendingHit<T>>> threadHits(threads);
+  std::vector<size_t>                     tests(threads, 0);
+  std::vector<size_t>                     found(threads, 0);
+
+#pragma omp parallel
+  {
+    int thread = 0;
+#ifdef _OPENMP
+    thread = omp_get_thread_num();
+#endif
+    BasicSegmentSoA<T> soa;
+    BasicKernelHits<T> hits;
+
+#pragma omp for schedule(dynamic, 64)
+    for (size_t c = 0; c < grid.cells(); ++c) {
+      int        m       = grid.count(c);
+      const int* members = grid.begin(c);
+      if (m < 2) continue;
+      if (info.mode == ResultMode::AnyIntersection && anyFound.load(std::memory_order_relaxed)) continue;
+
+      soa.gather(segments, members, m);
+      for (int a = 0; a + 1 < m; ++a) {
+        const BasicSegment<T>& seg = segments[members[a]];
+        tests[thread] += m - a - 1;
+
+        for (int block = a + 1; block < m; block += KERNEL_BLOCK) {
+          intersectBlock(seg, soa, block, std::min(KERNEL_BLOCK, m - block), hits);
+
+          for (uint64_t mask = hits.mask; mask; mask &= mask - 1) {
+            int                    k     = __builtin_ctzll(mask);
+            const BasicSegment<T>& other = segments[members[block + k]];
+            BasicPoint<T>          ip    = {hits.px[k], hits.py[k]};
+
+            // Reference point: the hit clamped to the common bounding box
+            auto clampTo = [](T v, T a0, T a1, T b0, T b1) {
+              T lo = std::max(std::min(a0, a1), std::min(b0, b1));
+              T hi = std::min(std::max(a0, a1), std::max(b0, b1));
+              return std::clamp(v, std::min(lo, hi), std::max(lo, hi));
+            };
+            T      rx    = clampTo(ip.x, seg.a.x, seg.b.x, other.a.x, other.b.x);
+            T      ry    = clampTo(ip.y, seg.a.y, seg.b.y, other.a.y, other.b.y);
+            size_t owner = grid.cellOf(rx, ry);
+            if (owner != c) {
+              if (grid.holds(owner, members[a]) && grid.holds(owner, members[block + k])) continue;
+              if (grid.firstShared(seg, members[block + k]) != c) continue;
+            }
+
+            found[thread]++;
+            if (keepHits) threadHits[thread].push_back({members[a], members[block + k], ip});
+            if (info.mode == ResultMode::AnyIntersection) anyFound.store(true, std::memory_order_relaxed);
+          }
+        }
+      }
+    }
+  }
+
+  BasicSweepResult<T> result;
+  HitReporter         reporter(info, result);
+  for (int t = 0; t < threads; ++t) {
+    result.eventsProcessed += tests[t];
+    if (!keepHits) result.intersectionCount += found[t];
+  }
+  reportMerged(threadHits, reporter);
+
+  if (info.mode == ResultMode::AnyIntersection)
+    result.intersectionCount = std::min<size_t>(result.intersectionCount, 1);
+
+  reporter.finish();
+  return result;
+}
+
+INSTANTIATE_ENGINE(findIntersectionsGrid)
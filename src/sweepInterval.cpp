@@ -1,113 +1,59 @@
 #include "sweep.hpp"
-#include <map>
-
-struct IntervalNode {
-  Segment       segment;
-  float         low, high;
-  IntervalNode* left  = nullptr;
-  IntervalNode* right = nullptr;
-  float         maxHigh;
-
-  IntervalNode(const Segment& seg) :
-    segment(seg), low(std::min(seg.a.x, seg.b.x)), high(std::max(seg.a.x, seg.b.x)), maxHigh(high) {}
-};
-
-class IntervalTree {
-  public:
-  IntervalTree() :
-    root(nullptr) {}
-  ~IntervalTree() { clear(root); }
-
-  void insert(const Segment& segment) {
-    root = insert(root, segment);
-  }
-
-  void search(const Segment& segment, std::vector<Segment>& result) const {
-    search(root, segment, result);
-  }
-
-  private:
-  IntervalNode* root;
-
-  void clear(IntervalNode* node) {
-    if (!node) return;
-    clear(node->left);
-    clear(node->right);
-    delete node;
-  }
-
-  IntervalNode* insert(IntervalNode* node, const Segment& segment) {
-    if (!node) return new IntervalNode(segment);
-
-    float low = std::min(segment.a.x, segment.b.x);
-    if (low < node->low) {
-      node->left = insert(node->left, segment);
-    } else {
-      node->right = insert(node->right, segment);
-    }
-
-    node->maxHigh = std::max(node->maxHigh, std::max(segment.a.x, segment.b.x));
-    return node;
-  }
-
-  bool overlaps(float low1, float high1, float low2, float high2) const {
-    return low1 <= high2 + EPS && low2 <= high1 + EPS;
-  }
-
-  void search(IntervalNode* node, const Segment& segment, std::vector<Segment>& result) const {
-    if (!node) return;
-
-    float low  = std::min(segment.a.x, segment.b.x);
-    float high = std::max(segment.a.x, segment.b.x);
-
-    if (overlaps(low, high, node->low, node->high)) {
-      result.push_back(node->segment);
-    }
-
-    if (node->left && node->left->maxHigh >= low - EPS) {
-      search(node->left, segment, result);
-    }
-
-    search(node->right, segment, result);
-  }
-};
-
-SweepResult findIntersectionsInterval(const Sweepinfo& info) {
-  SweepResult          result;
-  IntervalTree         tree;
-  std::map<Point, int> pointIndexMap;
-
-  for (int i = 0; i < info.segments.size(); ++i) {
-    const Segment&       seg = info.segments[i];
-    std::vector<Segment> candidates;
-    tree.search(seg, candidates);
-
-    for (const Segment& other : candidates) {
-      Point ip;
-      if (segmentsIntersect(seg, other, ip)) {
-        if (pointIndexMap.count(ip) == 0) {
-          pointIndexMap[ip] = result.intersectionPOints.size();
-          result.intersectionPOints.insert(ip);
-        }
-
-        for (const Segment& s : {seg, other}) {
-          if (s.a != ip && s.b != ip) {
-            result.intersectionSegments.insert(Segment(s.a, ip));
-            result.intersectionSegments.insert(Segment(ip, s.b));
-          } else {
-            result.intersectionSegments.insert(s);
-          }
-        }
-
-        int i1 = std::find(info.segments.begin(), info.segments.end(), seg) - info.segments.begin();
-        int i2 = std::find(info.segments.begin(), info.segments.end(), other) - info.segments.begin();
-
-        result.intersectionMaps[i1].insert(i2);
-        result.intersectionMaps[i2].insert(i1);
+#include "intervalIndex.hpp"
+#include "sweepKernel.hpp"
+#include "sweepReport.hpp"
+
+template <typename T>
+BasicSweepResult<T> findIntersectionsInterval(const BasicSweepinfo<T>& info) {
+  BasicSweepResult<T> result;
+  IntervalIndex       index(info.segments);
+  std::vector<int>    candidates; // entries of the short runs, tested from soa
+  BasicSegmentSoA<T>  soa;
+  BasicKernelHits<T>  hits;
+  HitReporter         reporter(info, result);
+
+  // Columns in index order, so a run of entries is a contiguous block
+  BasicSegmentSoA<T> sorted;
+  for (int k = 0; k < index.size(); ++k) sorted.push(info.segments[index.id(k)]);
+
+  // Tests segment i against columns[begin, end), entry(k) being the index
+  // entry of column k
+  auto testColumns = [&](int i, const BasicSegmentSoA<T>& columns, int begin, int end, auto entry) {
+    SWEEP_STAT(result.stats.pairTests += end - begin);
+    result.eventsProcessed += end - begin;
+    for (int block = begin; block < end && !reporter.stopped(); block += KERNEL_BLOCK) {
+      intersectBlock(info.segments[i], columns, block, std::min(KERNEL_BLOCK, end - block), hits);
+
+      for (uint64_t mask = hits.mask; mask && !reporter.stopped(); mask &= mask - 1) {
+        int k = __builtin_ctzll(mask);
+        reporter.add(i, index.id(entry(block + k)), BasicPoint<T>{hits.px[k], hits.py[k]});
       }
     }
-    tree.insert(seg);
+  };
+
+  // Entries go by low x and each one only queries those before it, so
+  // every overlapping pair comes up once. Long runs are tested in place,
+  // short ones are gathered first
+  for (int k = 0; k < index.size() && !reporter.stopped(); ++k) {
+    int i = index.id(k);
+    candidates.clear();
+    soa.clear();
+    [[maybe_unused]] size_t visited = index.runsBefore(k, [&](int begin, int end) {
+      if (end - begin >= KERNEL_BLOCK) {
+        testColumns(i, sorted, begin, end, [](int e) { return e; });
+        return;
+      }
+      for (int e = begin; e < end; ++e) {
+        candidates.push_back(e);
+        soa.push(info.segments[index.id(e)]);
+      }
+    });
+    SWEEP_STAT(result.stats.intervalNodesVisited += visited);
+    testColumns(i, soa, 0, candidates.size(), [&](int e) { return candidates[e]; });
   }
 
+  reporter.finish();
   return result;
 }
+
+INSTANTIATE_ENGINE(findIntersectionsInterval)
@@ -0,0 +1,163 @@
+#include "sweepKernel.hpp"
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+template <typename T>
+static inline void scalarLane(const BasicSegment<T>& s, const BasicSegmentSoA<T>& soa, size_t begin, int k, BasicKernelHits<T>& out) {
+  size_t c = begin + k;
+  if (intersectLane(s.a.x, s.a.y, s.b.x, s.b.y, soa.ax[c], soa.ay[c], soa.bx[c], soa.by[c], out.px[k], out.py[k]))
+    out.mask |= uint64_t(1) << k;
+}
+
+#if defined(__AVX2__)
+
+// Same expressions as orientFast, certain is cleared on uncertain lanes
+static inline __m256 orientVector(__m256 ax, __m256 ay, __m256 bx, __m256 by, __m256 cx, __m256 cy, __m256& certain) {
+  const __m256 sign  = _mm256_set1_ps(-0.0f);
+  const __m256 bound = _mm256_set1_ps(orientBound<float>);
+
+  __m256 l   = _mm256_mul_ps(_mm256_sub_ps(ax, cx), _mm256_sub_ps(by, cy));
+  __m256 r   = _mm256_mul_ps(_mm256_sub_ps(ay, cy), _mm256_sub_ps(bx, cx));
+  __m256 det = _mm256_sub_ps(l, r);
+  __m256 sum = _mm256_add_ps(_mm256_andnot_ps(sign, l), _mm256_andnot_ps(sign, r));
+  certain    = _mm256_and_ps(certain, _mm256_cmp_ps(_mm256_andnot_ps(sign, det), _mm256_mul_ps(bound, sum), _CMP_GT_OQ));
+  return det;
+}
+
+static int intersectVector(const Segment& s, const SegmentSoA& soa, size_t begin, int count, KernelHits& out) {
+  const __m256 all  = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+  const __m256 zero = _mm256_setzero_ps();
+
+  float        x1 = s.a.x, y1 = s.a.y, x2 = s.b.x, y2 = s.b.y;
+  const __m256 X1   = _mm256_set1_ps(x1);
+  const __m256 Y1   = _mm256_set1_ps(y1);
+  const __m256 X2   = _mm256_set1_ps(x2);
+  const __m256 Y2   = _mm256_set1_ps(y2);
+  const __m256 dx12 = _mm256_set1_ps(x1 - x2);
+  const __m256 dy12 = _mm256_set1_ps(y1 - y2);
+  const __m256 d12  = _mm256_set1_ps(x1 * y2 - y1 * x2);
+
+  int k = 0;
+  for (; k + 8 <= count; k += 8) {
+    __m256 x3 = _mm256_loadu_ps(&soa.ax[begin + k]);
+    __m256 y3 = _mm256_loadu_ps(&soa.ay[begin + k]);
+    __m256 x4 = _mm256_loadu_ps(&soa.bx[begin + k]);
+    __m256 y4 = _mm256_loadu_ps(&soa.by[begin + k]);
+
+    __m256 certain = all;
+    __m256 o1      = orientVector(X1, Y1, X2, Y2, x3, y3, certain);
+    __m256 o2      = orientVector(X1, Y1, X2, Y2, x4, y4, certain);
+    __m256 o3      = orientVector(x3, y3, x4, y4, X1, Y1, certain);
+    __m256 o4      = orientVector(x3, y3, x4, y4, X2, Y2, certain);
+
+    // Sign bit set where both pairs of orientations have opposite signs
+    __m256 straddle = _mm256_and_ps(_mm256_xor_ps(o1, o2), _mm256_xor_ps(o3, o4));
+
+    __m256 dx34  = _mm256_sub_ps(x3, x4);
+    __m256 dy34  = _mm256_sub_ps(y3, y4);
+    __m256 denom = _mm256_sub_ps(_mm256_mul_ps(dx12, dy34), _mm256_mul_ps(dy12, dx34));
+    __m256 d34   = _mm256_sub_ps(_mm256_mul_ps(x3, y4), _mm256_mul_ps(y3, x4));
+    __m256 px    = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(d12, dx34), _mm256_mul_ps(dx12, d34)), denom);
+    __m256 py    = _mm256_div_ps(_mm256_sub_ps(_mm256_mul_ps(d12, dy34), _mm256_mul_ps(dy12, d34)), denom);
+
+    int certainBits = _mm256_movemask_ps(certain);
+    int zeroBits    = _mm256_movemask_ps(_mm256_cmp_ps(denom, zero, _CMP_EQ_OQ));
+    int hitBits     = _mm256_movemask_ps(straddle) & certainBits;
+    int fixBits     = (~certainBits & 0xff) | (hitBits & zeroBits);
+
+    _mm256_storeu_ps(&out.px[k], px);
+    _mm256_storeu_ps(&out.py[k], py);
+    out.mask |= uint64_t(hitBits & ~zeroBits) << k;
+
+    for (; fixBits; fixBits &= fixBits - 1) scalarLane(s, soa, begin, k + __builtin_ctz(fixBits), out);
+  }
+  return k;
+}
+
+#elif defined(__SSE2__)
+
+// Same expressions as orientFast, certain is cleared on uncertain lanes
+static inline __m128 orientVector(__m128 ax, __m128 ay, __m128 bx, __m128 by, __m128 cx, __m128 cy, __m128& certain) {
+  const __m128 sign  = _mm_set1_ps(-0.0f);
+  const __m128 bound = _mm_set1_ps(orientBound<float>);
+
+  __m128 l   = _mm_mul_ps(_mm_sub_ps(ax, cx), _mm_sub_ps(by, cy));
+  __m128 r   = _mm_mul_ps(_mm_sub_ps(ay, cy), _mm_sub_ps(bx, cx));
+  __m128 det = _mm_sub_ps(l, r);
+  __m128 sum = _mm_add_ps(_mm_andnot_ps(sign, l), _mm_andnot_ps(sign, r));
+  certain    = _mm_and_ps(certain, _mm_cmpgt_ps(_mm_andnot_ps(sign, det), _mm_mul_ps(bound, sum)));
+  return det;
+}
+
+static int intersectVector(const Segment& s, const SegmentSoA& soa, size_t begin, int count, KernelHits& out) {
+  const __m128 all  = _mm_castsi128_ps(_mm_set1_epi32(-1));
+  const __m128 zero = _mm_setzero_ps();
+
+  float        x1 = s.a.x, y1 = s.a.y, x2 = s.b.x, y2 = s.b.y;
+  const __m128 X1   = _mm_set1_ps(x1);
+  const __m128 Y1   = _mm_set1_ps(y1);
+  const __m128 X2   = _mm_set1_ps(x2);
+  const __m128 Y2   = _mm_set1_ps(y2);
+  const __m128 dx12 = _mm_set1_ps(x1 - x2);
+  const __m128 dy12 = _mm_set1_ps(y1 - y2);
+  const __m128 d12  = _mm_set1_ps(x1 * y2 - y1 * x2);
+
+  int k = 0;
+  for (; k + 4 <= count; k += 4) {
+    __m128 x3 = _mm_loadu_ps(&soa.ax[begin + k]);
+    __m128 y3 = _mm_loadu_ps(&soa.ay[begin + k]);
+    __m128 x4 = _mm_loadu_ps(&soa.bx[begin + k]);
+    __m128 y4 = _mm_loadu_ps(&soa.by[begin + k]);
+
+    __m128 certain = all;
+    __m128 o1      = orientVector(X1, Y1, X2, Y2, x3, y3, certain);
+    __m128 o2      = orientVector(X1, Y1, X2, Y2, x4, y4, certain);
+    __m128 o3      = orientVector(x3, y3, x4, y4, X1, Y1, certain);
+    __m128 o4      = orientVector(x3, y3, x4, y4, X2, Y2, certain);
+
+    // Sign bit set where both pairs of orientations have opposite signs
+    __m128 straddle = _mm_and_ps(_mm_xor_ps(o1, o2), _mm_xor_ps(o3, o4));
+
+    __m128 dx34  = _mm_sub_ps(x3, x4);
+    __m128 dy34  = _mm_sub_ps(y3, y4);
+    __m128 denom = _mm_sub_ps(_mm_mul_ps(dx12, dy34), _mm_mul_ps(dy12, dx34));
+    __m128 d34   = _mm_sub_ps(_mm_mul_ps(x3, y4), _mm_mul_ps(y3, x4));
+    __m128 px    = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(d12, dx34), _mm_mul_ps(dx12, d34)), denom);
+    __m128 py    = _mm_div_ps(_mm_sub_ps(_mm_mul_ps(d12, dy34), _mm_mul_ps(dy12, d34)), denom);
+
+    int certainBits = _mm_movemask_ps(certain);
+    int zeroBits    = _mm_movemask_ps(_mm_cmpeq_ps(denom, zero));
+    int hitBits     = _mm_movemask_ps(straddle) & certainBits;
+    int fixBits     = (~certainBits & 0xf) | (hitBits & zeroBits);
+
+    _mm_storeu_ps(&out.px[k], px);
+    _mm_storeu_ps(&out.py[k], py);
+    out.mask |= uint64_t(hitBits & ~zeroBits) << k;
+
+    for (; fixBits; fixBits &= fixBits - 1) scalarLane(s, soa, begin, k + __builtin_ctz(fixBits), out);
+  }
+  return k;
+}
+
+#else
+
+static int intersectVector(const Segment&, const SegmentSoA&, size_t, int, KernelHits&) {
+  return 0;
+}
+
+#endif
+
+template <typename T>
+void intersectBlock(const BasicSegment<T>& s, const BasicSegmentSoA<T>& soa, size_t begin, int count, BasicKernelHits<T>& out) {
+  out.mask = 0;
+  int k    = 0;
+  if constexpr (std::is_same_v<T, float>) k = intersectVector(s, soa, begin, count, out);
+
+  for (; k < count; ++k) scalarLane(s, soa, begin, k, out);
+}
+
+template void intersectBlock(const BasicSegment<float>&, const BasicSegmentSoA<float>&, size_t, int, BasicKernelHits<float>&);
+template void intersectBlock(const BasicSegment<double>&, const BasicSegmentSoA<double>&, size_t, int, BasicKernelHits<double>&);
+template void intersectBlock(const BasicSegment<int32_t>&, const BasicSegmentSoA<int32_t>&, size_t, int, BasicKernelHits<int32_t>&);
+template void intersectBlock(const BasicSegment<int64_t>&, const BasicSegmentSoA<int64_t>&, size_t, int, BasicKernelHits<int64_t>&);
@@ -0,0 +1,145 @@
+#pragma once
+#include "sweep.hpp"
+#include "predicates.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/**
+ * Batched segment intersection kernel.
+ *
+ * One segment is tested against a block of up to KERNEL_BLOCK candidates
+ * stored as a SegmentSoA. For float coordinates the AVX2 (8 lanes) or
+ * SSE2 (4 lanes) path is selected at compile time, the scalar lane handles
+ * the tail, targets without either and the other coordinate types. Every
+ * path evaluates the same expressions in the same order as
+ * segmentsIntersect, so all engines agree bit for bit.
+ *
+ * The hit decision is exact: for floating point coordinates the four
+ * orientations are evaluated in T with a certified error bound, and lanes
+ * where any sign is uncertain are decided again by segmentsCrossExact;
+ * integer coordinates are decided exactly right away. The intersection
+ * point itself is the symmetric formula, rounded to T.
+ */
+
+inline constexpr int KERNEL_BLOCK = 64;
+
+template <typename T>
+struct BasicKernelHits {
+  uint64_t mask; // bit k set when lane k intersects
+  T        px[KERNEL_BLOCK], py[KERNEL_BLOCK];
+};
+
+using KernelHits = BasicKernelHits<float>;
+
+// Orient2d of c against a->b in T, clears certain when the sign is not exact
+template <typename T>
+inline T orientFast(T ax, T ay, T bx, T by, T cx, T cy, bool& certain) {
+  T l     = (ax - cx) * (by - cy);
+  T r     = (ay - cy) * (bx - cx);
+  T det   = l - r;
+  certain = certain && std::fabs(det) > orientBound<T> * (std::fabs(l) + std::fabs(r));
+  return det;
+}
+
+// Type the intersection point falls back to when T cannot represent it
+template <typename T>
+using WideCoord = std::conditional_t<std::is_same_v<T, float>, double, long double>;
+
+// Intersection point of two segments known to cross in exactly one point
+template <typename T>
+inline void crossingPoint(T x1, T y1, T x2, T y2, T x3, T y3, T x4, T y4, T& px, T& py) {
+  if constexpr (std::is_floating_point_v<T>) {
+    T denom = (x1 - x2) * (y3 - y4) - (y1 - y2) * (x3 - x4);
+    if (denom != 0) {
+      T d12 = x1 * y2 - y1 * x2;
+      T d34 = x3 * y4 - y3 * x4;
+      px    = (d12 * (x3 - x4) - (x1 - x2) * d34) / denom;
+      py    = (d12 * (y3 - y4) - (y1 - y2) * d34) / denom;
+      return;
+    }
+  }
+
+  // Nearly parallel pair whose denominator vanished, or integer coordinates
+  using W = WideCoord<T>;
+  W denom = (W(x1) - x2) * (W(y3) - y4) - (W(y1) - y2) * (W(x3) - x4);
+  W d12   = W(x1) * y2 - W(y1) * x2;
+  W d34   = W(x3) * y4 - W(y3) * x4;
+  W wx    = (d12 * (W(x3) - x4) - (W(x1) - x2) * d34) / denom;
+  W wy    = (d12 * (W(y3) - y4) - (W(y1) - y2) * d34) / denom;
+  if constexpr (std::is_integral_v<T>) {
+    px = T(std::llround(wx));
+    py = T(std::llround(wy));
+  } else {
+    px = T(wx);
+    py = T(wy);
+  }
+}
+
+/**
+ * Interval [lo, hi] surely holding the abscissa of the crossing of the lines
+ * through (x1, y1)-(x2, y2) and (x3, y3)-(x4, y4). X = num / den is evaluated
+ * in WideCoord with forward error bounds on num and den, several times the
+ * worst case of the operations involved, and the bound carried through the
+ * quotient. A den within its bound, nearly
+ * parallel lines, gives the whole axis; the sweeps order their crossings by
+ * these intervals and only decide exactly (crossingXSign, crossingXOrder)
+ * when two of them overlap.
+ */
+template <typename T>
+inline void crossingBounds(T x1, T y1, T x2, T y2, T x3, T y3, T x4, T y4, WideCoord<T>& lo, WideCoord<T>& hi) {
+  using W               = WideCoord<T>;
+  constexpr W ERR       = 16 * std::numeric_limits<W>::epsilon();
+  constexpr W UNBOUNDED = std::numeric_limits<W>::infinity();
+
+  W dx1 = W(x2) - x1, dy1 = W(y2) - y1, dx2 = W(x4) - x3, dy2 = W(y4) - y3;
+  W ox = W(x3) - x1, oy = W(y3) - y1;
+
+  W den    = dx1 * dy2 - dy1 * dx2;
+  W denErr = ERR * (std::fabs(dx1 * dy2) + std::fabs(dy1 * dx2));
+  W off    = ox * dy2 - oy * dx2;
+  W offErr = ERR * (std::fabs(ox * dy2) + std::fabs(oy * dx2));
+  W num    = x1 * den + dx1 * off;
+  W numErr = ERR * (std::fabs(x1 * den) + std::fabs(dx1 * off)) + std::fabs(W(x1)) * denErr + std::fabs(dx1) * offErr;
+
+  if (!(std::fabs(den) > denErr)) {
+    lo = -UNBOUNDED;
+    hi = UNBOUNDED;
+    return;
+  }
+
+  // |num / den - X| <= (numErr + |x| denErr) / (|den| - denErr), plus the
+  // rounding of the quotient
+  W x   = num / den;
+  W err = (numErr + std::fabs(x) * denErr) / (std::fabs(den) - denErr) + std::fabs(x) * ERR;
+  lo    = x - err;
+  hi    = x + err;
+}
+
+// Scalar lane: segment (x1, y1)-(x2, y2) against (x3, y3)-(x4, y4)
+template <typename T>
+inline bool intersectLane(T x1, T y1, T x2, T y2, T x3, T y3, T x4, T y4, T& px, T& py) {
+  bool hit;
+  if constexpr (std::is_integral_v<T>) {
+    hit = segmentsCross(x1, y1, x2, y2, x3, y3, x4, y4);
+  } else {
+    bool certain = true;
+    T    o1      = orientFast(x1, y1, x2, y2, x3, y3, certain);
+    T    o2      = orientFast(x1, y1, x2, y2, x4, y4, certain);
+    T    o3      = orientFast(x3, y3, x4, y4, x1, y1, certain);
+    T    o4      = orientFast(x3, y3, x4, y4, x2, y2, certain);
+
+    hit = certain ? ((o1 < 0) != (o2 < 0)) && ((o3 < 0) != (o4 < 0))
+                  : segmentsCross(x1, y1, x2, y2, x3, y3, x4, y4);
+  }
+  if (!hit) return false;
+
+  crossingPoint(x1, y1, x2, y2, x3, y3, x4, y4, px, py);
+  return true;
+}
+
+// Tests s against soa[begin, begin + count), count <= KERNEL_BLOCK
+template <typename T>
+void intersectBlock(const BasicSegment<T>& s, const BasicSegmentSoA<T>& soa, size_t begin, int count, BasicKernelHits<T>& out);
@@ -0,0 +1,51 @@
+#include "sweep.hpp"
+#include "boxTree.hpp"
+#include "sweepKernel.hpp"
+#include "sweepReport.hpp"
+
+static_assert(BoxTree<float>::FANOUT <= KERNEL_BLOCK, "a leaf must fit one kernel block");
+
+/**
+ * Bounding volume engine: a packed R-tree (boxTree.hpp) over the segment
+ * boxes joined with itself. Unlike the x-interval index, the 2D box prune
+ * also separates segments that share an x-band but lie far apart in y.
+ * Overlapping leaves are tested with the block kernel straight from one
+ * SoA copy laid out in leaf order.
+ */
+template <typename T>
+BasicSweepResult<T> findIntersectionsLibrary(const BasicSweepinfo<T>& info) {
+  const auto&             segments = info.segments;
+  BasicSweepResult<T>     result;
+  BoxTree<T>              tree(segments);
+  const std::vector<int>& order = tree.order();
+  BasicSegmentSoA<T>      soa;
+  BasicKernelHits<T>      hits;
+  HitReporter             reporter(info, result);
+
+  soa.gather(segments, order.data(), order.size());
+
+  tree.selfJoin([&](int a, int na, int b, int nb) {
+    for (int k = a; k < a + na && !reporter.stopped(); ++k) {
+      // A leaf joined with itself only tests the entries after k
+      int begin = a == b ? k + 1 : b;
+      int count = a == b ? a + na - begin : nb;
+      if (count <= 0) continue;
+
+      int                    i   = order[k];
+      const BasicSegment<T>& seg = segments[i];
+      result.eventsProcessed += count;
+      intersectBlock(seg, soa, begin, count, hits);
+
+      for (uint64_t mask = hits.mask; mask && !reporter.stopped(); mask &= mask - 1) {
+        int lane = __builtin_ctzll(mask);
+        reporter.add(i, order[begin + lane], BasicPoint<T>{hits.px[lane], hits.py[lane]});
+      }
+    }
+    return !reporter.stopped();
+  });
+
+  reporter.finish();
+  return result;
+}
+
+INSTANTIATE_ENGINE(findIntersectionsLibrary)
@@ -0,0 +1,133 @@
+#include "sweep.hpp"
+#include "sweepCore.hpp"
+#include "sweepReport.hpp"
+#include <atomic>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Slab partitioned parallel engine.
+ *
+ * The x-range is cut into vertical slabs holding the same number of segment
+ * endpoints. A segment is replicated into every slab its x-extent touches
+ * and each slab runs the Bentley-Ottmann sweep (sweepSegments) over its
+ * members clipped to the slab: segments reaching in from the left enter
+ * the status at once at the slab start and the sweep stops at its end. A
+ * pair is only reported by the slab owning the exact abscissa of its
+ * intersection, so pairs seen next to a boundary by two slabs are
+ * deduplicated without a merge pass. Hits reach the Sweepinfo sink once all
+ * slabs are done.
+ */
+
+template <typename T>
+struct SlabHit {
+  int           i, j;
+  BasicPoint<T> p;
+};
+
+// Collects the hits of one slab sweep under the global ids. Without a sink,
+// count and any modes only keep the counter; any mode also makes every
+// slab give up once one of them found a hit
+template <typename T>
+struct SlabReporter {
+  const std::vector<int>&  members;
+  std::vector<SlabHit<T>>& hits;
+  size_t&                  found;
+  bool                     keepHits, any;
+  std::atomic<bool>&       anyFound;
+
+  bool earlyExit() const { return any; }
+  bool stopped() const { return any && anyFound.load(std::memory_order_relaxed); }
+
+  void add(int i, int j, BasicPoint<T> p) {
+    found++;
+    if (keepHits) hits.push_back({members[i], members[j], p});
+    if (any) anyFound.store(true, std::memory_order_relaxed);
+  }
+};
+
+template <typename T>
+static int slabOf(const std::vector<T>& bounds, T x) {
+  return std::upper_bound(bounds.begin(), bounds.end(), x) - bounds.begin();
+}
+
+template <typename T>
+BasicSweepResult<T> findIntersectionsParallel(const BasicSweepinfo<T>& info) {
+  const auto& segments = info.segments;
+  int         n        = segments.size();
+
+  int threads = 1;
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+  // A few slabs per thread to even out slabs with many crossings
+  int slabs = std::max(1, std::min(4 * threads, n / 256));
+
+  // Interior boundaries at the endpoint quantiles, slab s covers
+  // [bounds[s - 1], bounds[s])
+  std::vector<T> endpoints;
+  endpoints.reserve(2 * n);
+  for (const BasicSegment<T>& s : segments) {
+    endpoints.push_back(s.a.x);
+    endpoints.push_back(s.b.x);
+  }
+  std::sort(endpoints.begin(), endpoints.end());
+
+  std::vector<T> bounds;
+  for (int s = 1; s < slabs; ++s) bounds.push_back(endpoints[size_t(s) * endpoints.size() / slabs]);
+  bounds.erase(std::unique(bounds.begin(), bounds.end()), bounds.end());
+  slabs = bounds.size() + 1;
+
+  // Replicate every segment into the slabs its x-extent spans, ids stay
+  // in increasing order inside each slab. A segment ending on a boundary
+  // also joins the slab after it, which owns crossings on the boundary
+  std::vector<std::vector<int>> members(slabs);
+  for (int i = 0; i < n; ++i) {
+    int first = slabOf(bounds, std::min(segments[i].a.x, segments[i].b.x));
+    int last  = slabOf(bounds, std::max(segments[i].a.x, segments[i].b.x));
+    for (int s = first; s <= last; ++s) members[s].push_back(i);
+  }
+
+  bool                                 keepHits = keepsHits(info);
+  std::atomic<bool>                    anyFound = false;
+  std::vector<std::vector<SlabHit<T>>> slabHits(slabs);
+  std::vector<size_t>                  events(slabs, 0);
+  std::vector<size_t>                  found(slabs, 0);
+
+#pragma omp parallel for schedule(dynamic, 1)
+  for (int s = 0; s < slabs; ++s) {
+    std::vector<BasicSegment<T>> local;
+    local.reserve(members[s].size());
+    for (int i : members[s]) local.push_back(segments[i]);
+    BasicSegmentSoA<T> columns;
+    columns.assign(local);
+
+    SweepStats       stats;
+    SlabReporter<T>  reporter{members[s], slabHits[s], found[s], keepHits, info.mode == ResultMode::AnyIntersection, anyFound};
+    std::optional<T> from, to;
+    if (s > 0) from = bounds[s - 1];
+    if (s + 1 < slabs) to = bounds[s];
+    sweepSegments<T, false>(local, columns, reporter, stats, events[s], from, to);
+  }
+
+  BasicSweepResult<T> result;
+  HitReporter         reporter(info, result);
+  for (int s = 0; s < slabs; ++s) {
+    result.eventsProcessed += events[s];
+    if (!keepHits) result.intersectionCount += found[s];
+
+    for (const SlabHit<T>& hit : slabHits[s]) {
+      if (reporter.stopped()) break;
+      reporter.add(hit.i, hit.j, hit.p);
+    }
+  }
+
+  if (info.mode == ResultMode::AnyIntersection)
+    result.intersectionCount = std::min<size_t>(result.intersectionCount, 1);
+
+  reporter.finish();
+  return result;
+}
+
+INSTANTIATE_ENGINE(findIntersectionsParallel)
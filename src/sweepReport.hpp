@@ -0,0 +1,129 @@
+#pragma once
+#include "sweep.hpp"
+#include "sweepSplit.hpp"
+#include <algorithm>
+#include <vector>
+
+/**
+ * Records the hits of an engine into its SweepResult according to the
+ * ResultMode requested in Sweepinfo, so engines skip building containers
+ * nobody asked for. intersectionCount is kept in every mode, and every hit
+ * is forwarded to the Sweepinfo sink when there is one.
+ */
+template <typename T>
+class HitReporter {
+  public:
+  HitReporter(const BasicSweepinfo<T>& info, BasicSweepResult<T>& result) :
+    mode(info.mode), sink(info.sink), result(result), segments(info.segments) {}
+
+  // AnyIntersection: report a hit as soon as it is detected, then stop
+  bool earlyExit() const { return mode == ResultMode::AnyIntersection; }
+  bool stopped() const { return stop; }
+
+  // Only Full asks for points and intersectionSegments
+  bool full() const { return mode == ResultMode::Full; }
+
+  void add(int i, int j, BasicPoint<T> p) {
+    result.intersectionCount++;
+    if (sink && !sink->emit({std::min(i, j), std::max(i, j), p})) stop = true;
+    switch (mode) {
+      case ResultMode::Full:
+        result.intersectionPOints.insert(p);
+        result.compact.records.push_back({std::min(i, j), std::max(i, j), p});
+        [[fallthrough]];
+      case ResultMode::PairsOnly:
+        result.intersectionMaps[i].insert(j);
+        result.intersectionMaps[j].insert(i);
+        break;
+      case ResultMode::CountOnly:
+        break;
+      case ResultMode::AnyIntersection:
+        stop = true;
+        break;
+      case ResultMode::Compact:
+        result.compact.records.push_back({std::min(i, j), std::max(i, j), p});
+        break;
+    }
+  }
+
+  // Bichromatic hit between red segment i and blue segment j: the record
+  // carries (i, j) in that order and the map only goes from red to blue
+  void addRedBlue(int i, int j, BasicPoint<T> p) {
+    result.intersectionCount++;
+    bichromatic = true;
+    if (sink && !sink->emit({i, j, p})) stop = true;
+    switch (mode) {
+      case ResultMode::Full:
+        result.intersectionPOints.insert(p);
+        result.compact.records.push_back({i, j, p});
+        [[fallthrough]];
+      case ResultMode::PairsOnly:
+        result.intersectionMaps[i].insert(j);
+        break;
+      case ResultMode::CountOnly:
+        break;
+      case ResultMode::AnyIntersection:
+        stop = true;
+        break;
+      case ResultMode::Compact:
+        result.compact.records.push_back({i, j, p});
+        break;
+    }
+  }
+
+  // Called once the engine is done: builds the adjacency of the records
+  // kept in Compact and Full mode, and in Full mode splits the hit segments
+  // of a symmetric graph at their crossings
+  void finish() {
+    if (mode != ResultMode::Compact && mode != ResultMode::Full) return;
+    result.compact.build(segments.size(), !bichromatic);
+    if (mode == ResultMode::Full && !bichromatic && !result.compact.records.empty())
+      result.intersectionSegments = splitSegments(segments, result.compact, false);
+  }
+
+  private:
+  ResultMode                          mode;
+  BasicIntersectionSink<T>*           sink;
+  BasicSweepResult<T>&                result;
+  const std::vector<BasicSegment<T>>& segments;
+  bool                                stop        = false;
+  bool                                bichromatic = false;
+};
+
+// Parallel engines buffer their hits only when some output needs them
+template <typename T>
+bool keepsHits(const BasicSweepinfo<T>& info) {
+  return info.sink || info.mode == ResultMode::Full || info.mode == ResultMode::PairsOnly || info.mode == ResultMode::Compact;
+}
+
+// Hit found by a worker thread, reported once every thread is done
+template <typename T>
+struct PendingHit {
+  int           i, j;
+  BasicPoint<T> p;
+};
+
+/**
+ * Merges the per thread hit buffers of a parallel engine: sorted by pair,
+ * duplicates dropped, then reported in that order so the result does not
+ * depend on the schedule.
+ */
+template <typename T>
+void reportMerged(std::vector<std::vector<PendingHit<T>>>& buffers, HitReporter<T>& reporter) {
+  std::vector<PendingHit<T>> all;
+  for (auto& buffer : buffers) {
+    all.insert(all.end(), buffer.begin(), buffer.end());
+    std::vector<PendingHit<T>>().swap(buffer);
+  }
+  std::sort(all.begin(), all.end(), [](const PendingHit<T>& l, const PendingHit<T>& r) {
+    return l.i != r.i ? l.i < r.i : l.j < r.j;
+  });
+  all.erase(std::unique(all.begin(), all.end(), [](const PendingHit<T>& l, const PendingHit<T>& r) {
+    return l.i == r.i && l.j == r.j;
+  }), all.end());
+
+  for (const PendingHit<T>& hit : all) {
+    if (reporter.stopped()) break;
+    reporter.add(hit.i, hit.j, hit.p);
+  }
+}
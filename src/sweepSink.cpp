@@ -0,0 +1,72 @@
+#include "sweepSink.hpp"
+#include <thread>
+
+RingBufferSink::RingBufferSink(size_t capacity) {
+  size_t size = 2;
+  while (size < capacity) size <<= 1;
+  buffer.resize(size);
+  mask = size - 1;
+}
+
+bool RingBufferSink::emit(const IntersectionRecord& record) {
+  size_t h = head.load(std::memory_order_relaxed);
+  while (h - tail.load(std::memory_order_acquire) == buffer.size()) {
+    if (cancelled.load(std::memory_order_acquire)) return false;
+    std::this_thread::yield();
+  }
+
+  buffer[h & mask] = record;
+  head.store(h + 1, std::memory_order_release);
+  return !cancelled.load(std::memory_order_relaxed);
+}
+
+bool RingBufferSink::pop(IntersectionRecord& record) {
+  size_t t = tail.load(std::memory_order_relaxed);
+  while (t == head.load(std::memory_order_acquire)) {
+    // close() follows the last emit(), so head is final once closed is seen
+    if (closed.load(std::memory_order_acquire) && t == head.load(std::memory_order_acquire))
+      return false;
+    std::this_thread::yield();
+  }
+
+  record = buffer[t & mask];
+  tail.store(t + 1, std::memory_order_release);
+  return true;
+}
+
+FileSink::FileSink(const std::string& path, size_t bufferRecords) :
+  capacity(std::max<size_t>(bufferRecords, 1)) {
+  file = std::fopen(path.c_str(), "wb");
+  pending.reserve(capacity);
+
+  // Placeholder header, the count is only known at close()
+  HitFileHeader header = {{'H', 'I', 'T', 'S'}, 1, 0};
+  good                 = file && std::fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+bool FileSink::emit(const IntersectionRecord& record) {
+  pending.push_back(record);
+  if (pending.size() == capacity) flush();
+  return ok();
+}
+
+bool FileSink::flush() {
+  if (!ok()) return false;
+  if (!pending.empty())
+    good = std::fwrite(pending.data(), sizeof(IntersectionRecord), pending.size(), file) == pending.size();
+  written += pending.size();
+  pending.clear();
+  return good;
+}
+
+bool FileSink::close() {
+  if (!file) return good;
+
+  flush();
+  HitFileHeader header = {{'H', 'I', 'T', 'S'}, 1, written};
+  good                 = good && std::fseek(file, 0, SEEK_SET) == 0 &&
+    std::fwrite(&header, sizeof(header), 1, file) == 1;
+  good = std::fclose(file) == 0 && good;
+  file = nullptr;
+  return good;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "sweep.hpp"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Forwards every hit to a callback, returning false stops the engine
+class CallbackSink : public IntersectionSink {
+  public:
+  explicit CallbackSink(std::function<bool(const IntersectionRecord& record)> callback) :
+    callback(std::move(callback)) {}
+
+  bool emit(const IntersectionRecord& record) override { return callback(record); }
+
+  private:
+  std::function<bool(const IntersectionRecord& record)> callback;
+};
+
+/**
+ * Bounded single producer, single consumer queue between the engine and a
+ * consumer thread. emit() waits while the buffer is full and pop() while
+ * it is empty; the producer calls close() once the engine returned, and
+ * the consumer may cancel() to make the engine stop at its next hit.
+ */
+class RingBufferSink : public IntersectionSink {
+  public:
+  explicit RingBufferSink(size_t capacity = 1 << 16);
+
+  bool emit(const IntersectionRecord& record) override;
+
+  // False once the stream is closed and drained
+  bool pop(IntersectionRecord& record);
+
+  void close() { closed.store(true, std::memory_order_release); }
+  void cancel() { cancelled.store(true, std::memory_order_release); }
+
+  private:
+  std::vector<IntersectionRecord> buffer;
+  size_t                          mask;
+  alignas(64) std::atomic<size_t> head{0}; // next slot to write
+  alignas(64) std::atomic<size_t> tail{0}; // next slot to read
+  std::atomic<bool>               closed{false};
+  std::atomic<bool>               cancelled{false};
+};
+
+/**
+ * Binary hit file: a HitFileHeader followed by count packed
+ * IntersectionRecord (segA, segB, x, y) entries. Records are buffered and
+ * written in large blocks; the final count is patched in by close().
+ */
+struct HitFileHeader {
+  char     magic[4]; // "HITS"
+  uint32_t version;  // 1
+  uint64_t count;
+};
+
+static_assert(sizeof(IntersectionRecord) == 16, "hit records are written as packed 16 byte entries");
+
+class FileSink : public IntersectionSink {
+  public:
+  explicit FileSink(const std::string& path, size_t bufferRecords = 1 << 16);
+  ~FileSink() override { close(); }
+
+  bool ok() const { return file && good; }
+  bool emit(const IntersectionRecord& record) override;
+
+  // Flushes the buffer and writes the header, false on any write error
+  bool close();
+
+  uint64_t count() const { return written + pending.size(); }
+
+  private:
+  FILE*                           file = nullptr;
+  bool                            good = true;
+  uint64_t                        written = 0;
+  size_t                          capacity;
+  std::vector<IntersectionRecord> pending;
+
+  bool flush();
+};
@@ -0,0 +1,80 @@
+#pragma once
+#include "sweep.hpp"
+#include "sweepKernel.hpp"
+#include <algorithm>
+#include <vector>
+
+/**
+ * Arrangement edges: every segment cut at the crossings lying on it.
+ *
+ * A post-pass over the hits in CSR form (BasicCompactResult), which hands
+ * each segment all its crossing points at once. They are ordered by their
+ * parameter along the segment, repeated points and the endpoints are
+ * dropped, and the pieces between consecutive cuts are written from a to b
+ * into one flat array, segment after segment; every piece carries the index
+ * of the segment it was cut from as its id. Segments are independent, so
+ * both passes (ordering the cuts, then writing the pieces at their prefix
+ * offset) run in parallel.
+ *
+ * A segment touched only at an endpoint comes out whole; segments without
+ * any hit only when uncut is set.
+ */
+template <typename T>
+std::vector<BasicSegment<T>> splitSegments(const std::vector<BasicSegment<T>>& segments,
+                                           const BasicCompactResult<T>& hits, bool uncut = true) {
+  long                       n = segments.size();
+  std::vector<BasicPoint<T>> cuts(hits.neighbors.size());
+  std::vector<size_t>        start(n + 1, 0);
+
+  // Cuts of segment i go to cuts[hits.offsets[i]...], start[i + 1] counts
+  // its pieces until the prefix sum below
+#pragma omp parallel
+  {
+    std::vector<std::pair<WideCoord<T>, BasicPoint<T>>> along;
+
+#pragma omp for schedule(dynamic, 1024)
+    for (long i = 0; i < n; ++i) {
+      size_t degree = i < (long)hits.segmentCount() ? hits.degree(i) : 0;
+      if (degree == 0) {
+        start[i + 1] = uncut;
+        continue;
+      }
+
+      const BasicSegment<T>& s  = segments[i];
+      WideCoord<T>           dx = WideCoord<T>(s.b.x) - s.a.x, dy = WideCoord<T>(s.b.y) - s.a.y;
+      along.clear();
+      for (size_t k = 0; k < degree; ++k) {
+        BasicPoint<T> p = hits.record(i, k).p;
+        along.push_back({(WideCoord<T>(p.x) - s.a.x) * dx + (WideCoord<T>(p.y) - s.a.y) * dy, p});
+      }
+      std::sort(along.begin(), along.end(), [](const auto& l, const auto& r) { return l.first < r.first; });
+
+      BasicPoint<T>* out  = cuts.data() + hits.offsets[i];
+      size_t         kept = 0;
+      for (const auto& [t, p] : along) {
+        if (p == s.a || p == s.b || (kept > 0 && p == out[kept - 1])) continue;
+        out[kept++] = p;
+      }
+      start[i + 1] = kept + 1;
+    }
+  }
+
+  for (long i = 0; i < n; ++i) start[i + 1] += start[i];
+  std::vector<BasicSegment<T>> pieces(start[n]);
+
+#pragma omp parallel for schedule(dynamic, 1024)
+  for (long i = 0; i < n; ++i) {
+    size_t count = start[i + 1] - start[i];
+    if (count == 0) continue;
+
+    const BasicSegment<T>& s    = segments[i];
+    const BasicPoint<T>*   cut  = cuts.data() + (i < (long)hits.segmentCount() ? hits.offsets[i] : 0);
+    BasicPoint<T>          from = s.a;
+    for (size_t k = 0; k + 1 < count; ++k) {
+      pieces[start[i] + k] = BasicSegment<T>(from, cut[k], int(i));
+      from                 = cut[k];
+    }
+    pieces[start[i + 1] - 1] = BasicSegment<T>(from, s.b, int(i));
+  }
+  return pieces;
+}
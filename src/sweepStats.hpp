@@ -0,0 +1,28 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+
+/**
+ * Hot path counters of the sweep and interval engines, filled only in
+ * builds configured with -DSWEEP_STATS=ON. Otherwise SWEEP_STAT() drops its
+ * statement at compile time and every counter stays 0.
+ */
+struct SweepStats {
+  size_t insertEvents         = 0; // insertions and vertical segments
+  size_t removeEvents         = 0;
+  size_t crossingEvents       = 0;
+  size_t comparatorCalls      = 0; // status order and slope sort comparisons
+  size_t pairTests            = 0; // candidate pairs handed to the intersection test
+  size_t duplicateSchedules   = 0; // pairs offered again after their first test
+  size_t maxStatusSize        = 0;
+  size_t maxQueueSize         = 0; // crossing heap, endpoints are presorted
+  size_t intervalNodesVisited = 0;
+
+  static void raise(size_t& counter, size_t value) { counter = std::max(counter, value); }
+};
+
+#ifdef SWEEP_STATS
+#define SWEEP_STAT(statement) statement
+#else
+#define SWEEP_STAT(statement)
+#endif
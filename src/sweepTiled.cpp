@@ -0,0 +1,100 @@
+#include "sweep.hpp"
+#include "sweepKernel.hpp"
+#include "sweepReport.hpp"
+#include <atomic>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/**
+ * Parallel all-pairs engine, the ground truth the other engines are
+ * validated against.
+ *
+ * The i x j triangle is cut into TILE x TILE blocks, so the columns of a j
+ * tile (16 KB of float SoA) stay in L1 while every segment of the i tile is
+ * run against it with the block kernel. Tiles are handed to threads
+ * dynamically, hits go to per thread buffers and are merged by sorting and
+ * dropping duplicates once all tiles are done. Every pair is tested, so the
+ * answer does not depend on any pruning.
+ */
+
+static constexpr int TILE = 1024;
+
+template <typename T>
+BasicSweepResult<T> findIntersectionsTiled(const BasicSweepinfo<T>& info) {
+  const auto&               segments = info.segments;
+  BasicSegmentSoA<T>        storage;
+  const BasicSegmentSoA<T>& soa = columnsOf(info, storage);
+  int                       n   = segments.size();
+
+  // Upper triangle of tile pairs, I <= J
+  int                              tiles = (n + TILE - 1) / TILE;
+  std::vector<std::pair<int, int>> tilePairs;
+  tilePairs.reserve(size_t(tiles) * (tiles + 1) / 2);
+  for (int I = 0; I < tiles; ++I)
+    for (int J = I; J < tiles; ++J) tilePairs.push_back({I, J});
+
+  int threads = 1;
+#ifdef _OPENMP
+  threads = omp_get_max_threads();
+#endif
+
+  bool                                    keepHits = keepsHits(info);
+  std::atomic<bool>                       anyFound = false;
+  std::vector<std::vector<PendingHit<T>>> threadHits(threads);
+  std::vector<size_t>                     tests(threads, 0);
+  std::vector<size_t>                     found(threads, 0);
+
+#pragma omp parallel
+  {
+    int thread = 0;
+#ifdef _OPENMP
+    thread = omp_get_thread_num();
+#endif
+    BasicKernelHits<T> hits;
+
+#pragma omp for schedule(dynamic, 1)
+    for (size_t t = 0; t < tilePairs.size(); ++t) {
+      if (info.mode == ResultMode::AnyIntersection && anyFound.load(std::memory_order_relaxed)) continue;
+
+      auto [I, J] = tilePairs[t];
+      int iEnd    = std::min(n, (I + 1) * TILE);
+      int jEnd    = std::min(n, (J + 1) * TILE);
+
+      size_t tileTests = 0, tileFound = 0;
+      for (int i = I * TILE; i < iEnd; ++i) {
+        for (int block = std::max(J * TILE, i + 1); block < jEnd; block += KERNEL_BLOCK) {
+          int count = std::min(KERNEL_BLOCK, jEnd - block);
+          intersectBlock(segments[i], soa, block, count, hits);
+          tileTests += count;
+          if (!hits.mask) continue;
+
+          tileFound += __builtin_popcountll(hits.mask);
+          for (uint64_t mask = hits.mask; keepHits && mask; mask &= mask - 1) {
+            int k = __builtin_ctzll(mask);
+            threadHits[thread].push_back({i, block + k, {hits.px[k], hits.py[k]}});
+          }
+          if (info.mode == ResultMode::AnyIntersection) anyFound.store(true, std::memory_order_relaxed);
+        }
+      }
+      tests[thread] += tileTests;
+      found[thread] += tileFound;
+    }
+  }
+
+  BasicSweepResult<T> result;
+  HitReporter         reporter(info, result);
+  for (int t = 0; t < threads; ++t) {
+    result.eventsProcessed += tests[t];
+    if (!keepHits) result.intersectionCount += found[t];
+  }
+  reportMerged(threadHits, reporter);
+
+  if (info.mode == ResultMode::AnyIntersection)
+    result.intersectionCount = std::min<size_t>(result.intersectionCount, 1);
+
+  reporter.finish();
+  return result;
+}
+
+INSTANTIATE_ENGINE(findIntersectionsTiled)
@@ -1,60 +1,48 @@
 #include "sweep.hpp"
+#include "sweepKernel.hpp"
+#include "sweepReport.hpp"
 #include <set>
 
-bool segmentsIntersect(const Segment& s1, const Segment& s2, Point& out) {
-  auto det = [](float a, float b, float c, float d) {
-    return a * d - b * c;
-  };
-
-  float x1 = s1.a.x, y1 = s1.a.y;
-  float x2 = s1.b.x, y2 = s1.b.y;
-  float x3 = s2.a.x, y3 = s2.a.y;
-  float x4 = s2.b.x, y4 = s2.b.y;
-
-  float denom = det(x1 - x2, y1 - y2, x3 - x4, y3 - y4);
-  if (fequal(denom, 0))
+template <typename T>
+bool segmentsIntersect(const BasicSegment<T>& s1, const BasicSegment<T>& s2, BasicPoint<T>& out) {
+  T px, py;
+  if (!intersectLane(s1.a.x, s1.a.y, s1.b.x, s1.b.y, s2.a.x, s2.a.y, s2.b.x, s2.b.y, px, py))
     return false;
-
-  float px =
-    det(det(x1, y1, x2, y2), x1 - x2, det(x3, y3, x4, y4), x3 - x4) / denom;
-  float py =
-    det(det(x1, y1, x2, y2), y1 - y2, det(x3, y3, x4, y4), y3 - y4) / denom;
-
-  if (std::min(x1, x2) - EPS <= px && px <= std::max(x1, x2) + EPS &&
-      std::min(y1, y2) - EPS <= py && py <= std::max(y1, y2) + EPS &&
-      std::min(x3, x4) - EPS <= px && px <= std::max(x3, x4) + EPS &&
-      std::min(y3, y4) - EPS <= py && py <= std::max(y3, y4) + EPS) {
-    out = {px, py};
-    return true;
-  }
-  return false;
+  out = {px, py};
+  return true;
 }
 
-SweepResult findIntersectionsNaive(const Sweepinfo& info) {
-  SweepResult result;
-
-  for (int i = 0; i < info.segments.size(); i++) {
-    for (int j = i + 1; j < info.segments.size(); j++) {
-
-      Point intersectionPoint;
-      if (!segmentsIntersect(info.segments[i], info.segments[j], intersectionPoint))
-        continue;
-
-      result.intersectionPOints.insert(intersectionPoint);
-
-      result.intersectionMaps[i].insert(j);
-      result.intersectionMaps[j].insert(i);
-
-      Segment a(info.segments[i].a, intersectionPoint);
-      Segment b(info.segments[i].b, intersectionPoint);
-      Segment c(info.segments[j].a, intersectionPoint);
-      Segment d(info.segments[j].b, intersectionPoint);
-
-      result.intersectionSegments.insert(a);
-      result.intersectionSegments.insert(b);
-      result.intersectionSegments.insert(c);
-      result.intersectionSegments.insert(d);
+template bool segmentsIntersect(const BasicSegment<float>&, const BasicSegment<float>&, BasicPoint<float>&);
+template bool segmentsIntersect(const BasicSegment<double>&, const BasicSegment<double>&, BasicPoint<double>&);
+template bool segmentsIntersect(const BasicSegment<int32_t>&, const BasicSegment<int32_t>&, BasicPoint<int32_t>&);
+template bool segmentsIntersect(const BasicSegment<int64_t>&, const BasicSegment<int64_t>&, BasicPoint<int64_t>&);
+
+template <typename T>
+BasicSweepResult<T> findIntersectionsNaive(const BasicSweepinfo<T>& info) {
+  BasicSweepResult<T>       result;
+  BasicSegmentSoA<T>        storage;
+  const BasicSegmentSoA<T>& soa = columnsOf(info, storage);
+  BasicKernelHits<T>        hits;
+  HitReporter               reporter(info, result);
+  int                       n = info.segments.size();
+
+  for (int i = 0; i < n && !reporter.stopped(); i++) {
+    for (int block = i + 1; block < n && !reporter.stopped(); block += KERNEL_BLOCK) {
+      int count = std::min(KERNEL_BLOCK, n - block);
+      intersectBlock(info.segments[i], soa, block, count, hits);
+      result.eventsProcessed += count;
+
+      for (uint64_t mask = hits.mask; mask && !reporter.stopped(); mask &= mask - 1) {
+        int           k                 = __builtin_ctzll(mask);
+        int           j                 = block + k;
+        BasicPoint<T> intersectionPoint = {hits.px[k], hits.py[k]};
+
+        reporter.add(i, j, intersectionPoint);
+      }
     }
   }
+  reporter.finish();
   return result;
 }
+
+INSTANTIATE_ENGINE(findIntersectionsNaive)
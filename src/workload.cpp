@@ -0,0 +1,160 @@
+#include "workload.hpp"
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <random>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static Point randomPoint(std::mt19937& gen, float domain) {
+  std::uniform_real_distribution<float> dis(0.0f, domain);
+  float                                 x = dis(gen);
+  float                                 y = dis(gen);
+  return Point{x, y};
+}
+
+// Segment of the given length centered at a random point with random direction
+static Segment randomStick(std::mt19937& gen, float domain, float length, int id) {
+  std::uniform_real_distribution<float> angle(0.0f, 2.0f * float(M_PI));
+  Point                                 c  = randomPoint(gen, domain);
+  float                                 th = angle(gen);
+  float                                 dx = 0.5f * length * std::cos(th);
+  float                                 dy = 0.5f * length * std::sin(th);
+  return Segment{Point{c.x - dx, c.y - dy}, Point{c.x + dx, c.y + dy}, id};
+}
+
+Sweepinfo generateUniform(long n, unsigned seed, float domain) {
+  std::mt19937 gen(seed);
+  Sweepinfo    info;
+  info.segments.reserve(n);
+  for (long i = 0; i < n; ++i) {
+    Point a = randomPoint(gen, domain);
+    Point b = randomPoint(gen, domain);
+    info.segments.emplace_back(a, b, int(i));
+  }
+  return info;
+}
+
+Sweepinfo generateShort(long n, unsigned seed, float domain) {
+  std::mt19937 gen(seed);
+  Sweepinfo    info;
+  float        length = domain / std::sqrt(float(n));
+  info.segments.reserve(n);
+  for (long i = 0; i < n; ++i)
+    info.segments.push_back(randomStick(gen, domain, length, int(i)));
+  return info;
+}
+
+Sweepinfo generateLong(long n, unsigned seed, float domain) {
+  std::mt19937                          gen(seed);
+  std::uniform_real_distribution<float> len(0.5f * domain, domain);
+  Sweepinfo                             info;
+  info.segments.reserve(n);
+  for (long i = 0; i < n; ++i) {
+    float length = len(gen);
+    info.segments.push_back(randomStick(gen, domain, length, int(i)));
+  }
+  return info;
+}
+
+Sweepinfo generateNearParallel(long n, unsigned seed, float domain) {
+  std::mt19937                          gen(seed);
+  std::uniform_real_distribution<float> left(0.0f, 0.1f * domain);
+  std::uniform_real_distribution<float> right(0.9f * domain, domain);
+  std::uniform_real_distribution<float> y(0.0f, domain);
+  std::normal_distribution<float>       jitter(0.0f, 1e-3f * domain);
+  Sweepinfo                             info;
+  info.segments.reserve(n);
+  for (long i = 0; i < n; ++i) {
+    float x0 = left(gen), x1 = right(gen);
+    float y0 = y(gen), y1 = y0 + jitter(gen);
+    info.segments.emplace_back(Point{x0, y0}, Point{x1, y1}, int(i));
+  }
+  return info;
+}
+
+Sweepinfo generateGrid(long n, unsigned seed, float domain) {
+  (void)seed;
+  Sweepinfo info;
+  long      h = n / 2, v = n - n / 2;
+  info.segments.reserve(n);
+  for (long i = 0; i < h; ++i) {
+    float y = domain * (i + 0.5f) / h;
+    info.segments.emplace_back(Point{0, y}, Point{domain, y}, int(i));
+  }
+  for (long i = 0; i < v; ++i) {
+    float x = domain * (i + 0.5f) / v;
+    info.segments.emplace_back(Point{x, 0}, Point{x, domain}, int(h + i));
+  }
+  return info;
+}
+
+template <typename Scalar>
+static void convertSegments(const Scalar* data, uint64_t count, std::vector<Segment>& segments) {
+  segments.reserve(count);
+  for (uint64_t i = 0; i < count; ++i) {
+    const Scalar* s = data + 4 * i;
+    segments.emplace_back(Point{float(s[0]), float(s[1])}, Point{float(s[2]), float(s[3])}, int(i));
+  }
+}
+
+std::optional<Sweepinfo> loadSegments(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) return std::nullopt;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || size_t(st.st_size) < sizeof(SegmentFileHeader)) {
+    close(fd);
+    return std::nullopt;
+  }
+
+  size_t size = st.st_size;
+  void*  map  = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) return std::nullopt;
+  madvise(map, size, MADV_SEQUENTIAL);
+
+  SegmentFileHeader header;
+  std::memcpy(&header, map, sizeof(header));
+
+  bool valid = std::memcmp(header.magic, "SEGS", 4) == 0 &&
+    header.version == SEGMENT_FILE_VERSION &&
+    (header.scalarSize == sizeof(float) || header.scalarSize == sizeof(double)) &&
+    header.count <= (size - sizeof(header)) / (4 * header.scalarSize);
+
+  std::optional<Sweepinfo> info;
+  if (valid) {
+    info.emplace();
+    const char* data = static_cast<const char*>(map) + sizeof(header);
+    if (header.scalarSize == sizeof(float))
+      convertSegments(reinterpret_cast<const float*>(data), header.count, info->segments);
+    else
+      convertSegments(reinterpret_cast<const double*>(data), header.count, info->segments);
+  }
+
+  munmap(map, size);
+  return info;
+}
+
+bool saveSegments(const std::string& path, const Sweepinfo& info, bool doublePrecision) {
+  FILE* file = std::fopen(path.c_str(), "wb");
+  if (!file) return false;
+
+  SegmentFileHeader header = {{'S', 'E', 'G', 'S'}, SEGMENT_FILE_VERSION, 0, 0, info.segments.size()};
+  header.scalarSize        = doublePrecision ? sizeof(double) : sizeof(float);
+
+  bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+  for (const Segment& s : info.segments) {
+    if (!ok) break;
+    if (doublePrecision) {
+      double v[4] = {s.a.x, s.a.y, s.b.x, s.b.y};
+      ok          = std::fwrite(v, sizeof(v), 1, file) == 1;
+    } else {
+      float v[4] = {s.a.x, s.a.y, s.b.x, s.b.y};
+      ok         = std::fwrite(v, sizeof(v), 1, file) == 1;
+    }
+  }
+
+  return std::fclose(file) == 0 && ok;
+}
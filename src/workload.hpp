@@ -0,0 +1,65 @@
+#pragma once
+#include "sweep.hpp"
+#include <cstdint>
+#include <optional>
+#include <string>
+
+/**
+ * Reproducible workloads: every generator is a pure function of (n, seed,
+ * domain), so two runs with the same arguments see the same segments.
+ * Segment ids are set to their index in Sweepinfo::segments.
+ */
+
+// Both endpoints uniform in [0, domain]^2
+Sweepinfo generateUniform(long n, unsigned seed, float domain = 100.0f);
+
+// Random direction, length ~ domain / sqrt(n): number of hits grows linearly
+Sweepinfo generateShort(long n, unsigned seed, float domain = 100.0f);
+
+// Random direction, length in [domain / 2, domain]: quadratic number of hits
+Sweepinfo generateLong(long n, unsigned seed, float domain = 100.0f);
+
+// Almost horizontal segments spanning the domain, stresses the status order
+Sweepinfo generateNearParallel(long n, unsigned seed, float domain = 100.0f);
+
+// n/2 horizontal and n/2 vertical lines, every horizontal hits every vertical
+Sweepinfo generateGrid(long n, unsigned seed, float domain = 100.0f);
+
+/**
+ * Copy of info in coordinate type T with every coordinate multiplied by
+ * scale; integer types snap to the nearest grid point. The result mode is
+ * kept, sinks and prebuilt columns are not.
+ */
+template <typename T>
+BasicSweepinfo<T> convertSegments(const Sweepinfo& info, double scale = 1.0) {
+  auto convert = [scale](float c) {
+    if constexpr (std::is_integral_v<T>) return T(std::llround(double(c) * scale));
+    else return T(double(c) * scale);
+  };
+
+  BasicSweepinfo<T> converted;
+  converted.mode = info.mode;
+  converted.segments.reserve(info.segments.size());
+  for (const Segment& s : info.segments)
+    converted.segments.emplace_back(BasicPoint<T>{convert(s.a.x), convert(s.a.y)},
+                                    BasicPoint<T>{convert(s.b.x), convert(s.b.y)}, s.id);
+  return converted;
+}
+
+/**
+ * Binary segment file: a SegmentFileHeader followed by count * 4 packed
+ * scalars (ax, ay, bx, by), scalars being float or double as given by
+ * scalarSize. The file is memory mapped and converted in a single pass.
+ */
+struct SegmentFileHeader {
+  char     magic[4];   // "SEGS"
+  uint32_t version;    // 1
+  uint32_t scalarSize; // 4 (float) or 8 (double)
+  uint32_t reserved;
+  uint64_t count;
+};
+
+inline constexpr uint32_t SEGMENT_FILE_VERSION = 1;
+
+std::optional<Sweepinfo> loadSegments(const std::string& path);
+bool                     saveSegments(const std::string& path, const Sweepinfo& info, bool doublePrecision = false);